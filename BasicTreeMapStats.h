@@ -0,0 +1,608 @@
+/*
+# Purpose: Header-only, generic version of TreeMapStats: an ordered map ADT based on an AVL tree in which
+# every node also keeps an aggregate (e.g., count, sum, min, max) of the map values stored in its subtree
+# NOTE: the key type, the value type, the key comparator and the aggregate are compile-time parameters, so
+# the aggregate update is inlined and a node only stores the aggregate fields that are actually requested
+*/
+
+#ifndef BASIC_TREE_MAP_STATS_H
+#define BASIC_TREE_MAP_STATS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <new>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#include "EulerTour.h"
+#include "NodePool.h"
+
+/*
+# Purpose: Accumulators for the sums kept by the aggregate policies
+# NOTE: WideSum<V>::type is the default accumulator type for sums of values of type V: a 64-bit integer of the
+# signedness of V for integral values (which cannot overflow when summing up to 2^31 values of 32 bits or
+# less), and V itself otherwise; an accumulator must hold every value it sums
+# NOTE: an integral sum is kept modulo 2^bits (see wrappingAdd), together with the net number of times it
+# wrapped around, so the exact sum is value + wraps * 2^bits; a combine of two sums is then exact integer
+# addition, which is associative (unlike saturating at the limits of the accumulator, whose result would depend
+# on the order of the additions, i.e., on the shape of the tree), and the sum overflowed iff wraps != 0
+# NOTE: WrapCount<S, N>::type is the type of the wraps of a sum of at most the maximum of N values: each value
+# added wraps a sum around at most once, upwards for an unsigned sum; a signed sum takes values of at most half
+# the modulus in magnitude, so its net wraps are at most about half the number of values either way (and half
+# the range of N, the signed type of its size, is enough)
+*/
+template <class V, bool = std::is_integral<V>::value>
+struct WideSum { typedef V type; };
+
+template <class V>
+struct WideSum<V, true> { typedef typename std::conditional<std::is_signed<V>::value, long long, unsigned long long>::type type; };
+
+template <class S, class N>
+struct WrapCount { typedef typename std::conditional<std::is_signed<S>::value, typename std::make_signed<N>::type, N>::type type; };
+
+// OUTPUT: a + b, wrapped around on integral overflow; wraps is incremented (decremented) if the sum wrapped
+// around past the largest (lowest) representable value
+template <class S, class W>
+inline S wrappingAdd(const S& a, const S& b, W& wraps) {
+  if constexpr (std::is_integral<S>::value) {
+    S r;
+    if (__builtin_add_overflow(a, b, &r)) {
+      if (b > S()) wraps++;
+      else wraps--;
+    }
+    return r;
+  }
+  else
+    return a + b;
+}
+
+// OUTPUT: a * a, wrapped around on integral overflow; wraps is incremented if it overflowed (as a single wrap
+// around, however many there were: the square then still counts as a term beyond the range of S, and squares
+// are never negative, so a sum of squares overflowed iff its wraps are nonzero)
+template <class S>
+inline S wrappingSquare(const S& a, long long& wraps) {
+  if constexpr (std::is_integral<S>::value) {
+    S r;
+    if (__builtin_mul_overflow(a, a, &r)) wraps++;
+    return r;
+  }
+  else
+    return a * a;
+}
+
+/*
+# Purpose: Aggregate policies for BasicTreeMapStats
+# NOTE: an aggregate policy is a monoid over the map values: it defines the aggregate type, its identity
+# element (the aggregate of an empty subtree), lift (the aggregate of a single map value) and an associative
+# combine operation; the aggregate of a subtree is combine(combine(left, lift(value)), right)
+*/
+
+// number of map entries in the subtree, counted in N
+template <class N>
+struct BasicCountAggregate {
+  typedef N type;
+  static type identity() { return 0; }
+  template <class V> static type lift(const V&) { return 1; }
+  static type combine(const type& a, const type& b) { return a + b; }
+};
+
+typedef BasicCountAggregate<size_t> CountAggregate;
+
+// sum of the map values in the subtree, accumulated in S
+template <class V, class S = typename WideSum<V>::type>
+struct SumAggregate {
+  struct type {
+    S sum;
+    long long wraps;  // see wrappingAdd
+
+    // overloading output stream for a representation of sum s
+    friend std::ostream& operator<<(std::ostream& os, const type& s) {
+      os << s.sum;
+      return os;
+    };
+  };
+  static type identity() { return type{S(), 0}; }
+  static type lift(const V& v) { return type{S(v), 0}; }
+  static type combine(const type& a, const type& b) {
+    long long w = a.wraps + b.wraps;
+    S s = wrappingAdd(a.sum, b.sum, w);
+    return type{s, w};
+  }
+  static bool overflowed(const type& s) { return s.wraps != 0; }
+};
+
+// number of entries (counted in N), and sum (accumulated in S), minimum and maximum of the map values in the
+// subtree (as in TreeMapStats); the fields are ordered so that a 32-bit N packs with the wraps
+template <class V, class S = typename WideSum<V>::type, class N = size_t>
+struct StatsAggregate {
+  typedef typename WrapCount<S, N>::type W;
+  struct type {
+    S sum;
+    N num;
+    W wraps;  // of the sum (see wrappingAdd)
+    V min;
+    V max;
+
+    // overloading output stream for a representation of stats s
+    friend std::ostream& operator<<(std::ostream& os, const type& s) {
+      os << "{" << s.num << "," << s.sum << "," << s.min << "," << s.max << "}";
+      return os;
+    };
+  };
+  static type identity() { return type{S(), 0, 0, std::numeric_limits<V>::max(), std::numeric_limits<V>::lowest()}; }
+  static type lift(const V& v) { return type{S(v), 1, 0, v, v}; }
+  static type combine(const type& a, const type& b) {
+    W w = a.wraps + b.wraps;
+    S s = wrappingAdd(a.sum, b.sum, w);
+    return type{s, a.num + b.num, w, std::min(a.min, b.min), std::max(a.max, b.max)};
+  }
+  static bool overflowed(const type& s) { return s.wraps != 0; }
+};
+
+// number of entries, and sum and sum of squares (both accumulated in S) of the map values in the subtree,
+// from which the mean and the (population) variance of any subtree follow
+template <class V, class S = typename WideSum<V>::type>
+struct MomentsAggregate {
+  struct type {
+    size_t num;
+    S sum;
+    S sumSq;
+    long long wraps;    // of the sum (see wrappingAdd)
+    long long sqWraps;  // of the sum of squares (see wrappingSquare)
+
+    // overloading output stream for a representation of moments s
+    friend std::ostream& operator<<(std::ostream& os, const type& s) {
+      os << "{" << s.num << "," << s.sum << "," << s.sumSq << "}";
+      return os;
+    };
+  };
+  static type identity() { return type{0, S(), S(), 0, 0}; }
+  static type lift(const V& v) {
+    long long sw = 0;
+    S sq = wrappingSquare(S(v), sw);
+    return type{1, S(v), sq, 0, sw};
+  }
+  static type combine(const type& a, const type& b) {
+    long long w = a.wraps + b.wraps;
+    long long sw = a.sqWraps + b.sqWraps;
+    S s = wrappingAdd(a.sum, b.sum, w);
+    S sq = wrappingAdd(a.sumSq, b.sumSq, sw);
+    return type{a.num + b.num, s, sq, w, sw};
+  }
+  static bool overflowed(const type& s) { return s.wraps != 0 || s.sqWraps != 0; }
+  // OUTPUT: mean and variance of the values summarized by s (0 if s is empty; meaningless if s overflowed)
+  static double mean(const type& s) { return s.num ? (double) s.sum / s.num : 0.0; }
+  static double variance(const type& s) {
+    if (!s.num) return 0.0;
+    double m = mean(s);
+    return std::max(0.0, (double) s.sumSq / s.num - m * m);
+  }
+};
+
+/*
+# Purpose: Node classes for the templated maps; each layer extends the one below by inheritance, with
+# the concrete node type N passed down so that the links are typed without casts and no vtable is needed
+*/
+
+// node of a BST-based map: map entry and links
+template <class N, class K, class V>
+class BSTNodeBase {
+public:
+  K key;
+  V value;
+  N* left;
+  N* right;
+  N* parent;
+
+  // node constructor
+  BSTNodeBase(const K& k, const V& v, N* p) : key(k), value(v), left(NULL), right(NULL), parent(p) { };
+};
+
+// node of an AVL-tree-based map: adds the node height
+template <class N, class K, class V>
+class AVLNodeBase : public BSTNodeBase<N, K, V> {
+public:
+  int ht;
+
+  // node constructor
+  AVLNodeBase(const K& k, const V& v, N* p) : BSTNodeBase<N, K, V>(k, v, p), ht(1) { };
+};
+
+template <class K, class V>
+class BSTMapNode : public BSTNodeBase<BSTMapNode<K, V>, K, V> {
+public:
+  BSTMapNode(const K& k, const V& v, BSTMapNode* p) : BSTNodeBase<BSTMapNode, K, V>(k, v, p) { };
+};
+
+template <class K, class V>
+class AVLTreeMapNode : public AVLNodeBase<AVLTreeMapNode<K, V>, K, V> {
+public:
+  AVLTreeMapNode(const K& k, const V& v, AVLTreeMapNode* p) : AVLNodeBase<AVLTreeMapNode, K, V>(k, v, p) { };
+};
+
+// node of a TreeMapStats-like map: adds the aggregate of the subtree
+template <class K, class V, class Aggregate>
+class TreeMapStatsNode : public AVLNodeBase<TreeMapStatsNode<K, V, Aggregate>, K, V> {
+public:
+  typename Aggregate::type info;
+
+  TreeMapStatsNode(const K& k, const V& v, TreeMapStatsNode* p) :
+    AVLNodeBase<TreeMapStatsNode, K, V>(k, v, p), info(Aggregate::lift(v)) { };
+};
+
+/*
+# Purpose: Class definition of BSTMapBase, the BST layer of the templated maps (the counterpart of BSTMap)
+# NOTE: the layers are combined with the curiously recurring template pattern: the most derived map class,
+# Derived, is a template parameter, and the points where BSTMap calls virtual functions (createNode,
+# putNode/eraseNode extensions, printNode) are static calls to hooks of Derived, resolved at compile time
+# NOTE: hooks, which a layer above may hide with its own version:
+#   createNode(k, v, p): construct a node in the node pool
+#   afterInsert(w): called after a new node w is linked into the tree
+#   afterAssign(w): called after the value of an existing node w is replaced
+#   afterRemove(z): called after a node is unlinked, with its former parent z (possibly NULL)
+#   printNode(os, w): print a representation of node w
+*/
+template <class Derived, class Node, class K, class V, class Compare>
+class BSTMapBase
+{
+
+public:
+  // tree constructors
+  BSTMapBase() : root(NULL), n(0) { };
+  explicit BSTMapBase(const Compare& c) : root(NULL), n(0), comp(c) { };
+  // tree destructor
+  ~BSTMapBase() { clear(); };
+
+  // basic map operations
+  Node* find(const K& k) const;
+  void put(const K& k, const V& v);
+  void erase(const K& k);
+  size_t size() const { return n; };
+  bool empty() const { return !root; };
+  void clear();
+  // print utilities
+  void print(std::ostream& os) const { printAux(os, root, false); os << "\n"; };    // parenthetic string
+  void printMap(std::ostream& os) const { printAux(os, root, true); os << "\n"; };  // parenthetic string of entries
+
+protected:
+  // data members: tree root node; tree size; key comparator; allocator for all the nodes of the tree
+  Node* root;
+  size_t n;
+  Compare comp;
+  NodePool pool;
+
+  Derived& derived() { return *static_cast<Derived*>(this); };
+  const Derived& derived() const { return *static_cast<const Derived*>(this); };
+
+  // default hooks
+  Node* createNode(const K& k, const V& v, Node* p) { return new (pool.allocate(sizeof(Node))) Node(k, v, p); };
+  void afterInsert(Node*) { };
+  void afterAssign(Node*) { };
+  void afterRemove(Node*) { };
+  void printNode(std::ostream& os, const Node* w) const { os << w->key << ":" << w->value; };
+
+  // auxiliary utilities
+  bool equiv(const K& a, const K& b) const { return !comp(a, b) && !comp(b, a); };
+  void makeChild(Node* p, Node* c, bool isLeft);
+  Node* findNode(const K& k) const;
+  Node* removeNode(Node* w);
+  void destroyAll(Node* w);
+  void printAux(std::ostream& os, const Node* w, bool simple) const;
+
+private:
+  BSTMapBase(const BSTMapBase&) = delete;
+  BSTMapBase& operator=(const BSTMapBase&) = delete;
+};
+
+/*
+  # INPUT: nodes p, c in the tree, and isLeft as a predicate
+  # POSTCONDITION: c becomes the left child of p if isLeft is true and the right child otherwise;
+  # and p becomes the parent of c
+*/
+template <class D, class N, class K, class V, class C>
+inline void
+BSTMapBase<D,N,K,V,C>::makeChild(N* p, N* c, bool isLeft) {
+  if (p) {
+    if (isLeft) p->left = c;
+    else p->right = c;
+  }
+  if (c) c->parent = p;
+}
+
+/*
+  # INPUT: a key k
+  # OUTPUT: the last node visited while trying to find a node with key k in the tree
+*/
+template <class D, class N, class K, class V, class C>
+N*
+BSTMapBase<D,N,K,V,C>::findNode(const K& k) const {
+  N* w = root;
+  N* z = NULL;
+  while (w) {
+    // evaluate both comparisons unconditionally: the equality exit is rarely taken, and the left/right
+    // choice then compiles to a conditional move instead of an unpredictable branch
+    bool goLeft = comp(k, w->key);
+    bool goRight = comp(w->key, k);
+    if (!(goLeft | goRight)) break;
+    z = w;
+    w = goLeft ? w->left : w->right;
+  }
+  return w ? w : z;
+}
+
+/*
+  # INPUT: a key k
+  # OUTPUT: the tree node with key k if in the map; otherwise returns NULL
+*/
+template <class D, class N, class K, class V, class C>
+N*
+BSTMapBase<D,N,K,V,C>::find(const K& k) const {
+  N* w = findNode(k);
+  return (w && equiv(w->key, k)) ? w : NULL;
+}
+
+/*
+  # INPUT: a key-value pair k and v
+  # POSTCONDITION: if key k is already in the map, then its map value is v; otherwise, a new node with the
+  # entry is added as a leaf; the corresponding hook of Derived is called in either case
+*/
+template <class D, class N, class K, class V, class C>
+void
+BSTMapBase<D,N,K,V,C>::put(const K& k, const V& v) {
+  N* w = findNode(k);
+  if (w && equiv(w->key, k)) {
+    w->value = v;
+    derived().afterAssign(w);
+    return;
+  }
+  N* x = derived().createNode(k, v, w);
+  if (w) makeChild(w, x, comp(k, w->key));
+  else root = x;
+  n++;
+  derived().afterInsert(x);
+}
+
+/*
+  # INPUT: a node w in the tree
+  # OUTPUT: the parent of w, which may be NULL if w is the root
+  # PRECONDITION: the left or right subtree, or both, of w are empty
+  # POSTCONDITION: w is removed from the tree and its storage returned to the node pool
+*/
+template <class D, class N, class K, class V, class C>
+N*
+BSTMapBase<D,N,K,V,C>::removeNode(N* w) {
+  N* z = w->parent;
+  N* x = (w->left) ? w->left : w->right;
+  makeChild(z, x, !z || (z->left == w));
+  if (!z) root = x;
+  w->~N();
+  pool.deallocate(w, sizeof(N));
+  n--;
+  return z;
+}
+
+/*
+  # INPUT: a key k
+  # POSTCONDITION: no node in the tree has key k; if a node was removed, the afterRemove hook of Derived is called
+*/
+template <class D, class N, class K, class V, class C>
+void
+BSTMapBase<D,N,K,V,C>::erase(const K& k) {
+  N* w = findNode(k);
+  if (!w || !equiv(w->key, k)) return;
+  if (w->left && w->right) {
+    // replace the entry by that of its successor, and remove the successor node instead
+    N* s = w->right;
+    while (s->left) s = s->left;
+    w->key = s->key;
+    w->value = s->value;
+    w = s;
+  }
+  derived().afterRemove(removeNode(w));
+}
+
+// POSTCONDITION: the subtree rooted at w has its node destructors run, in postorder (only needed for non-trivial nodes)
+template <class D, class N, class K, class V, class C>
+void
+BSTMapBase<D,N,K,V,C>::destroyAll(N* w) {
+  eulerTour(w, [](N* x, TourStep step, int) { if (step == TOUR_POST) x->~N(); });
+}
+
+// POSTCONDITION: the map is empty; the node pool is released in bulk
+template <class D, class N, class K, class V, class C>
+void
+BSTMapBase<D,N,K,V,C>::clear() {
+  if (!std::is_trivially_destructible<N>::value) destroyAll(root);
+  root = NULL;
+  n = 0;
+  pool.release();
+}
+
+// utility/aux function to print out a parenthetic string representation of the subtree rooted at w
+template <class D, class N, class K, class V, class C>
+void
+BSTMapBase<D,N,K,V,C>::printAux(std::ostream& os, const N* w, bool simple) const {
+  eulerTour(w, [this, &os, simple](const N* x, TourStep step, int) {
+    if (step == TOUR_PRE) {
+      os << "[";
+      if (simple) BSTMapBase::printNode(os, x);
+      else derived().printNode(os, x);
+      os << "](";
+    }
+    else if (step == TOUR_IN) os << "),(";
+    else os << ")";
+  });
+}
+
+/*
+# Purpose: Class definition of AVLTreeMapBase, the AVL layer of the templated maps (the counterpart of AVLTreeMap)
+# NOTE: additional hook for the layers above:
+#   resetNode(w): recompute the per-node data of w (here its height) from its children
+# NOTE: after a put or erase, a single upward pass from the changed position resets and, where needed,
+# rebalances each node; the pass stops once heights stop changing unless Derived::updatesWholePath is set
+# (a layer keeping subtree aggregates needs every ancestor up to the root reset)
+*/
+template <class Derived, class Node, class K, class V, class Compare>
+class AVLTreeMapBase : public BSTMapBase<Derived, Node, K, V, Compare>
+{
+  typedef BSTMapBase<Derived, Node, K, V, Compare> Base;
+  friend Base;
+
+public:
+  AVLTreeMapBase() { };
+  explicit AVLTreeMapBase(const Compare& c) : Base(c) { };
+
+  static const bool updatesWholePath = false;
+
+protected:
+  // hooks
+  void resetNode(Node* w) { w->ht = std::max(height(w->left), height(w->right)) + 1; };
+  void afterInsert(Node* w) { updatePath(w->parent); };
+  void afterRemove(Node* z) { updatePath(z); };
+  void printNode(std::ostream& os, const Node* w) const { Base::printNode(os, w); os << "(" << w->ht << ")"; };
+
+  // auxiliary utilities
+  static int height(const Node* w) { return w ? w->ht : 0; };
+  Node* tallestChild(Node* w, bool breakLeft) const;
+  void singleRotation(Node* y, Node* z);
+  Node* rebalance(Node* z);
+  void updatePath(Node* w);
+};
+
+/*
+  # INPUT: a node w in the tree
+  # OUTPUT: the tallest child of w, breaking ties based on the value of the input breakLeft predicate
+*/
+template <class D, class N, class K, class V, class C>
+inline N*
+AVLTreeMapBase<D,N,K,V,C>::tallestChild(N* w, bool breakLeft) const {
+  int l_ht = height(w->left);
+  int r_ht = height(w->right);
+  return ((l_ht > r_ht) || ((l_ht == r_ht) && breakLeft)) ? w->left : w->right;
+}
+
+/*
+  # INPUT: nodes y and z in the tree
+  # PRECONDITION: y is a child of z
+  # POSTCONDITION: y takes the place of z, with z as its child; z and y are reset (see resetNode hook)
+*/
+template <class D, class N, class K, class V, class C>
+void
+AVLTreeMapBase<D,N,K,V,C>::singleRotation(N* y, N* z) {
+  if (z->parent) {
+    this->makeChild(z->parent, y, z->parent->left == z);
+  } else {
+    y->parent = NULL;
+    this->root = y;
+  }
+  bool rotateLeft = y == z->right;
+  N* t = rotateLeft ? y->left : y->right;
+  this->makeChild(z, t, !rotateLeft);
+  this->makeChild(y, z, rotateLeft);
+  this->derived().resetNode(z);
+  this->derived().resetNode(y);
+}
+
+/*
+  # INPUT: a node z in the tree
+  # OUTPUT: the new root node of the subtree originally rooted at z
+  # PRECONDITION: z is the only unbalanced node in the subtree that it roots; the difference in height of its children is exactly 2
+  # POSTCONDITION: the subtree originally rooted at z is a proper AVL subtree with its nodes properly reset
+*/
+template <class D, class N, class K, class V, class C>
+N*
+AVLTreeMapBase<D,N,K,V,C>::rebalance(N* z) {
+  N* y = tallestChild(z, true);
+  N* x = tallestChild(y, z->left == y);
+  if ((y == z->left) == (x == y->left)) {
+    singleRotation(y, z);
+    return y;
+  }
+  singleRotation(x, y);
+  singleRotation(x, z);
+  return x;
+}
+
+/*
+  # INPUT: a node w in the tree, or NULL
+  # POSTCONDITION: in a single pass from w upwards, every node on the path is reset and rebalanced if
+  # needed; the tree is a proper AVL tree with all nodes properly reset
+*/
+template <class D, class N, class K, class V, class C>
+void
+AVLTreeMapBase<D,N,K,V,C>::updatePath(N* w) {
+  while (w) {
+    N* p = w->parent;
+    int old_height = w->ht;
+    if (std::abs(height(w->left) - height(w->right)) > 1) w = rebalance(w);
+    else this->derived().resetNode(w);
+    if (!D::updatesWholePath && w->ht == old_height) break;
+    w = p;
+  }
+}
+
+/*
+# Purpose: Class definitions of the concrete templated maps: BasicBSTMap and BasicAVLTreeMap (plain ordered
+# maps), and BasicTreeMapStats, mapping keys of type K to values of type V using an AVL tree whose nodes keep
+# the Aggregate of their subtree; keys are ordered by Compare
+# NOTE: no virtual functions and no vtable pointer per node; BasicTreeMapStats makes the same rebalancing
+# decisions as TreeMapStats, so for int keys and values with StatsAggregate<int> both produce the same trees
+*/
+template <class K, class V, class Compare = std::less<K> >
+class BasicBSTMap : public BSTMapBase<BasicBSTMap<K, V, Compare>, BSTMapNode<K, V>, K, V, Compare>
+{
+public:
+  typedef BSTMapNode<K, V> Node;
+
+  BasicBSTMap() { };
+  explicit BasicBSTMap(const Compare& c) : BSTMapBase<BasicBSTMap, Node, K, V, Compare>(c) { };
+};
+
+template <class K, class V, class Compare = std::less<K> >
+class BasicAVLTreeMap : public AVLTreeMapBase<BasicAVLTreeMap<K, V, Compare>, AVLTreeMapNode<K, V>, K, V, Compare>
+{
+public:
+  typedef AVLTreeMapNode<K, V> Node;
+
+  BasicAVLTreeMap() { };
+  explicit BasicAVLTreeMap(const Compare& c) : AVLTreeMapBase<BasicAVLTreeMap, Node, K, V, Compare>(c) { };
+};
+
+template <class K, class V, class Aggregate = StatsAggregate<V>, class Compare = std::less<K> >
+class BasicTreeMapStats :
+  public AVLTreeMapBase<BasicTreeMapStats<K, V, Aggregate, Compare>, TreeMapStatsNode<K, V, Aggregate>, K, V, Compare>
+{
+  typedef AVLTreeMapBase<BasicTreeMapStats, TreeMapStatsNode<K, V, Aggregate>, K, V, Compare> Base;
+  friend BSTMapBase<BasicTreeMapStats, TreeMapStatsNode<K, V, Aggregate>, K, V, Compare>;
+  friend Base;
+
+public:
+  typedef TreeMapStatsNode<K, V, Aggregate> Node;
+  typedef typename Aggregate::type Info;
+
+  BasicTreeMapStats() { };
+  explicit BasicTreeMapStats(const Compare& c) : Base(c) { };
+
+  static const bool updatesWholePath = true;
+
+  // OUTPUT: the aggregate of the whole map (the identity if the map is empty)
+  Info stats() const { return info(this->root); };
+
+protected:
+  // hooks
+  void resetNode(Node* w) {
+    Base::resetNode(w);
+    w->info = Aggregate::combine(Aggregate::combine(info(w->left), Aggregate::lift(w->value)), info(w->right));
+  };
+  void afterAssign(Node* w) { this->updatePath(w); };
+  void printNode(std::ostream& os, const Node* w) const { Base::printNode(os, w); os << w->info; };
+
+  // auxiliary utilities
+  static Info info(const Node* w) { return w ? w->info : Aggregate::identity(); };
+};
+
+#endif // BASIC_TREE_MAP_STATS_H
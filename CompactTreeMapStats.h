@@ -0,0 +1,388 @@
+/*
+# Purpose: Header-only, compact version of BasicTreeMapStats: the nodes live in one contiguous array and are
+# linked by 32-bit indices into it instead of 64-bit pointers, with no parent link, and the aggregates count
+# the entries in 32 bits, so a map of fewer than 2^32 entries needs less than half the storage per entry,
+# and more of the tree fits in the caches
+*/
+
+#ifndef COMPACT_TREE_MAP_STATS_H
+#define COMPACT_TREE_MAP_STATS_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "BasicTreeMapStats.h"
+
+// aggregates of a CompactTreeMapStats: StatsAggregate and CountAggregate counting the entries in 32 bits
+template <class V>
+using CompactStatsAggregate = StatsAggregate<V, typename WideSum<V>::type, uint32_t>;
+typedef BasicCountAggregate<uint32_t> CompactCountAggregate;
+
+// node of a CompactTreeMapStats: map entry, child links (as indices into the node array of the map), height,
+// and the aggregate of the subtree
+template <class K, class V, class Aggregate>
+class CompactTreeMapStatsNode {
+public:
+  typedef uint32_t Index;
+
+  K key;
+  V value;
+  Index left;
+  Index right;
+  int ht;
+  typename Aggregate::type info;
+
+  // node constructor
+  CompactTreeMapStatsNode(const K& k, const V& v) :
+    key(k), value(v), left(0), right(0), ht(1), info(Aggregate::lift(v)) { };
+};
+
+/*
+# Purpose: Class definition of CompactTreeMapStats, mapping keys of type K to values of type V using an AVL tree
+# whose nodes keep the Aggregate of their subtree; keys are ordered by Compare
+# NOTE: the nodes are stored in a vector and linked by their indices in it; index 0 (NIL) is a sentinel node
+# with height 0 and the identity aggregate, standing for the empty subtree, so heights and aggregates of
+# children are read without a NULL test; the nodes of erased entries are linked into a free list (through
+# their left index) and reused by later puts; clear() returns all the storage at once
+# NOTE: as in PathStackTreeMapStats, the nodes have no parent link: put and erase keep the nodes on the way
+# down on a stack of MAX_HEIGHT indices, and reset and rebalance them by popping it (no AVL tree of at most
+# MAX_SIZE nodes is taller, as F(48) - 1 > MAX_SIZE, for the Fibonacci numbers F)
+# NOTE: K and V must be default constructible (for the sentinel); a map holds at most MAX_SIZE entries, so a
+# 32-bit count (as in CompactStatsAggregate, the default) is enough
+# NOTE: the updates make the same rebalancing decisions as BasicTreeMapStats, so both build the same trees;
+# unlike its nodes, the nodes of this map move when the array grows, so the node returned by find is only
+# valid until the next update (reserve() avoids the moves, and the transient doubling of memory, if the
+# final size is known)
+*/
+template <class K, class V, class Aggregate = CompactStatsAggregate<V>, class Compare = std::less<K> >
+class CompactTreeMapStats
+{
+
+public:
+  typedef CompactTreeMapStatsNode<K, V, Aggregate> Node;
+  typedef typename Node::Index Index;
+  typedef typename Aggregate::type Info;
+
+  static const Index NIL = 0;
+  static const size_t MAX_SIZE = 0xffffffffu;
+  static const int MAX_HEIGHT = 45;
+
+  // map constructors
+  CompactTreeMapStats() : root(NIL), freeList(NIL), n(0) { nodes.push_back(sentinel()); };
+  explicit CompactTreeMapStats(const Compare& c) : root(NIL), freeList(NIL), n(0), comp(c) { nodes.push_back(sentinel()); };
+
+  // basic map operations
+  const Node* find(const K& k) const;
+  void put(const K& k, const V& v);
+  bool erase(const K& k);
+  size_t size() const { return n; };
+  bool empty() const { return root == NIL; };
+  void clear();
+  // POSTCONDITION: the node array has room for m entries without growing
+  void reserve(size_t m) { nodes.reserve(m + 1); };
+  // OUTPUT: the aggregate of the map entries with keys in [lo, hi]
+  Info rangeStats(const K& lo, const K& hi) const;
+  // OUTPUT: the aggregate of the whole map (the identity if the map is empty)
+  Info stats() const { return nodes[root].info; };
+  // OUTPUT: the bytes of node storage held by the map, including free and reserved nodes
+  size_t memoryBytes() const { return nodes.capacity() * sizeof(Node); };
+  // print utilities
+  void print(std::ostream& os) const { printAux(os, root, false); os << "\n"; };    // parenthetic string
+  void printMap(std::ostream& os) const { printAux(os, root, true); os << "\n"; };  // parenthetic string of entries
+
+private:
+  // data members: node array (the sentinel first); tree root node; head of the free list; tree size; key comparator
+  std::vector<Node> nodes;
+  Index root;
+  Index freeList;
+  size_t n;
+  Compare comp;
+
+  static Node sentinel() {
+    Node s{K(), V()};
+    s.ht = 0;
+    s.info = Aggregate::identity();
+    return s;
+  };
+
+  // auxiliary utilities (as in PathStackTreeMapStats and PathCopyingTreeMapBase, on indices)
+  Index descend(const K& k, Index path[], int& d) const;
+  Index createNode(const K& k, const V& v);
+  void freeNode(Index w);
+  void replaceChild(Index p, Index c, Index x);
+  void resetNode(Index w);
+  Index rotate(Index z, bool rotateLeft);
+  Index balance(Index t);
+  void updatePath(Index path[], int d);
+  void printAux(std::ostream& os, Index w, bool simple) const;
+};
+
+/*
+  # INPUT: a key k
+  # OUTPUT: the node with key k (NULL if k is not in the map), valid until the next update of the map
+*/
+template <class K, class V, class A, class C>
+const typename CompactTreeMapStats<K,V,A,C>::Node*
+CompactTreeMapStats<K,V,A,C>::find(const K& k) const {
+  Index w = root;
+  while (w != NIL) {
+    // as BSTMapBase::findNode: both comparisons unconditionally, so the descent is a conditional move
+    const Node& x = nodes[w];
+    bool goLeft = comp(k, x.key);
+    bool goRight = comp(x.key, k);
+    if (!(goLeft | goRight)) return &x;
+    w = goLeft ? x.left : x.right;
+  }
+  return NULL;
+}
+
+/*
+  # INPUT: a key k, and an empty stack of nodes, path (of MAX_HEIGHT entries), with d = 0
+  # OUTPUT: the node with key k (NIL if k is not in the map)
+  # POSTCONDITION: path[0..d-1] are the nodes visited from the root down before the returned one, the root first
+*/
+template <class K, class V, class A, class C>
+inline typename CompactTreeMapStats<K,V,A,C>::Index
+CompactTreeMapStats<K,V,A,C>::descend(const K& k, Index path[], int& d) const {
+  Index w = root;
+  while (w != NIL) {
+    const Node& x = nodes[w];
+    bool goLeft = comp(k, x.key);
+    bool goRight = comp(x.key, k);
+    if (!(goLeft | goRight)) break;
+    path[d++] = w;
+    w = goLeft ? x.left : x.right;
+  }
+  return w;
+}
+
+/*
+  # INPUT: a key-value pair k and v
+  # OUTPUT: the index of a new node with the entry, taken from the free list, or else appended to the array
+*/
+template <class K, class V, class A, class C>
+inline typename CompactTreeMapStats<K,V,A,C>::Index
+CompactTreeMapStats<K,V,A,C>::createNode(const K& k, const V& v) {
+  if (freeList != NIL) {
+    Index w = freeList;
+    freeList = nodes[w].left;
+    nodes[w] = Node(k, v);
+    return w;
+  }
+  if (nodes.size() > MAX_SIZE) throw std::length_error("CompactTreeMapStats: too many entries");
+  nodes.push_back(Node(k, v));
+  return (Index) (nodes.size() - 1);
+}
+
+// POSTCONDITION: node w, out of the tree, is linked into the free list
+template <class K, class V, class A, class C>
+inline void
+CompactTreeMapStats<K,V,A,C>::freeNode(Index w) {
+  nodes[w].left = freeList;
+  freeList = w;
+}
+
+/*
+  # INPUT: a node p (or NIL for the root pointer), one of its children c, and a node x (or NIL)
+  # POSTCONDITION: x takes the place of c as a child of p (or as the root)
+*/
+template <class K, class V, class A, class C>
+inline void
+CompactTreeMapStats<K,V,A,C>::replaceChild(Index p, Index c, Index x) {
+  if (p == NIL) root = x;
+  else if (nodes[p].left == c) nodes[p].left = x;
+  else nodes[p].right = x;
+}
+
+/*
+  # INPUT: a key-value pair k and v
+  # POSTCONDITION: the map maps k to v; the nodes on the path to the root are reset and rebalanced
+*/
+template <class K, class V, class A, class C>
+void
+CompactTreeMapStats<K,V,A,C>::put(const K& k, const V& v) {
+  Index path[MAX_HEIGHT];
+  int d = 0;
+  Index w = descend(k, path, d);
+  if (w != NIL) {
+    nodes[w].value = v;
+    resetNode(w);
+  } else {
+    // the node is created before its parent is looked at, as the array may move
+    Index x = createNode(k, v);
+    if (d == 0) root = x;
+    else if (comp(k, nodes[path[d - 1]].key)) nodes[path[d - 1]].left = x;
+    else nodes[path[d - 1]].right = x;
+    n++;
+  }
+  updatePath(path, d);
+}
+
+/*
+  # INPUT: a key k
+  # OUTPUT: true iff k was in the map
+  # POSTCONDITION: no node in the tree has key k; the nodes on the path to the root are reset and rebalanced
+*/
+template <class K, class V, class A, class C>
+bool
+CompactTreeMapStats<K,V,A,C>::erase(const K& k) {
+  Index path[MAX_HEIGHT];
+  int d = 0;
+  Index w = descend(k, path, d);
+  if (w == NIL) return false;
+  if (nodes[w].left != NIL && nodes[w].right != NIL) {
+    // replace the entry by that of its successor, and remove the successor node instead
+    path[d++] = w;
+    Index s = nodes[w].right;
+    while (nodes[s].left != NIL) {
+      path[d++] = s;
+      s = nodes[s].left;
+    }
+    nodes[w].key = nodes[s].key;
+    nodes[w].value = nodes[s].value;
+    w = s;
+  }
+  replaceChild((d > 0) ? path[d - 1] : NIL, w, (nodes[w].left != NIL) ? nodes[w].left : nodes[w].right);
+  freeNode(w);
+  n--;
+  updatePath(path, d);
+  return true;
+}
+
+// POSTCONDITION: the map is empty; the node array is released
+template <class K, class V, class A, class C>
+void
+CompactTreeMapStats<K,V,A,C>::clear() {
+  std::vector<Node>().swap(nodes);
+  nodes.push_back(sentinel());
+  root = NIL;
+  freeList = NIL;
+  n = 0;
+}
+
+// POSTCONDITION: the height and aggregate of node w are recomputed from its children
+template <class K, class V, class A, class C>
+inline void
+CompactTreeMapStats<K,V,A,C>::resetNode(Index w) {
+  Node& x = nodes[w];
+  const Node& l = nodes[x.left];
+  const Node& r = nodes[x.right];
+  x.ht = std::max(l.ht, r.ht) + 1;
+  x.info = A::combine(A::combine(l.info, A::lift(x.value)), r.info);
+}
+
+/*
+  # INPUT: a node z, and the direction of the rotation
+  # OUTPUT: the new root of the subtree rooted at z, after a single rotation at z; z and that root are reset
+  # NOTE: as PathCopyingTreeMapBase::rotate; the parent of z is left to the caller
+*/
+template <class K, class V, class A, class C>
+typename CompactTreeMapStats<K,V,A,C>::Index
+CompactTreeMapStats<K,V,A,C>::rotate(Index z, bool rotateLeft) {
+  Node& x = nodes[z];
+  Index y = rotateLeft ? x.right : x.left;
+  if (rotateLeft) {
+    x.right = nodes[y].left;
+    nodes[y].left = z;
+  } else {
+    x.left = nodes[y].right;
+    nodes[y].right = z;
+  }
+  resetNode(z);
+  resetNode(y);
+  return y;
+}
+
+/*
+  # INPUT: a node t whose children are proper AVL subtrees differing in height by at most 2
+  # OUTPUT: the root of a proper AVL subtree with the entries of the subtree rooted at t, with nodes reset
+  # NOTE: as PathCopyingTreeMapBase::balance
+*/
+template <class K, class V, class A, class C>
+typename CompactTreeMapStats<K,V,A,C>::Index
+CompactTreeMapStats<K,V,A,C>::balance(Index t) {
+  Node& x = nodes[t];
+  int d = nodes[x.left].ht - nodes[x.right].ht;
+  if (d > 1) {
+    const Node& l = nodes[x.left];
+    if (nodes[l.left].ht < nodes[l.right].ht) x.left = rotate(x.left, true);
+    return rotate(t, false);
+  }
+  if (d < -1) {
+    const Node& r = nodes[x.right];
+    if (nodes[r.right].ht < nodes[r.left].ht) x.right = rotate(x.right, false);
+    return rotate(t, true);
+  }
+  resetNode(t);
+  return t;
+}
+
+/*
+  # INPUT: a stack of d nodes, path, from the root down
+  # POSTCONDITION: the nodes are rebalanced (if needed) and reset, from the deepest one up (the whole path, since
+  # every ancestor keeps the aggregate of its subtree); each parent then links to the new root of its subtree
+*/
+template <class K, class V, class A, class C>
+inline void
+CompactTreeMapStats<K,V,A,C>::updatePath(Index path[], int d) {
+  while (d > 0) {
+    Index w = path[--d];
+    Index t = balance(w);
+    if (t != w) replaceChild((d > 0) ? path[d - 1] : NIL, w, t);
+  }
+}
+
+/*
+  # INPUT: keys lo and hi, not necessarily in the map
+  # OUTPUT: the aggregate of the entries with keys in [lo, hi] (the identity if there are none)
+  # NOTE: O(log n), as PathCopyingTreeMapBase::rangeInfo; the parts of the range are combined in key order
+*/
+template <class K, class V, class A, class C>
+typename A::type
+CompactTreeMapStats<K,V,A,C>::rangeStats(const K& lo, const K& hi) const {
+  // find the split node: the first node on the search path with key in [lo, hi]
+  Index w = root;
+  while (w != NIL && (comp(nodes[w].key, lo) || comp(hi, nodes[w].key)))
+    w = comp(nodes[w].key, lo) ? nodes[w].right : nodes[w].left;
+  if (w == NIL) return A::identity();
+  Info l = A::identity();
+  Info r = A::identity();
+  // entries with keys >= lo in the left subtree of the split node, from the largest down
+  for (Index x = nodes[w].left; x != NIL; ) {
+    if (!comp(nodes[x].key, lo)) {
+      l = A::combine(A::combine(A::lift(nodes[x].value), nodes[nodes[x].right].info), l);
+      x = nodes[x].left;
+    }
+    else x = nodes[x].right;
+  }
+  // entries with keys <= hi in the right subtree of the split node, from the smallest up
+  for (Index x = nodes[w].right; x != NIL; ) {
+    if (!comp(hi, nodes[x].key)) {
+      r = A::combine(r, A::combine(nodes[nodes[x].left].info, A::lift(nodes[x].value)));
+      x = nodes[x].right;
+    }
+    else x = nodes[x].left;
+  }
+  return A::combine(A::combine(l, A::lift(nodes[w].value)), r);
+}
+
+// utility/aux function to print out a parenthetic string representation of the subtree rooted at w
+// (in the format of BasicTreeMapStats)
+template <class K, class V, class A, class C>
+void
+CompactTreeMapStats<K,V,A,C>::printAux(std::ostream& os, Index w, bool simple) const {
+  eulerTour(w, NIL, [this](Index x) { return nodes[x].left; }, [this](Index x) { return nodes[x].right; },
+            [this, &os, simple](Index i, TourStep step, int) {
+    const Node& x = nodes[i];
+    if (step == TOUR_PRE) {
+      os << "[" << x.key << ":" << x.value;
+      if (!simple) os << "(" << x.ht << ")" << x.info;
+      os << "](";
+    }
+    else if (step == TOUR_IN) os << "),(";
+    else os << ")";
+  });
+}
+
+#endif // COMPACT_TREE_MAP_STATS_H
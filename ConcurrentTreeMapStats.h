@@ -0,0 +1,341 @@
+/*
+# Purpose: Header-only, thread-safe version of BasicTreeMapStats for many concurrent readers and a writer:
+# readers never block (no locks, no retries); writers build a new version of the tree by path copying and
+# publish its root atomically, and the nodes they replace are reclaimed only once no reader can reach them
+# (epoch-based reclamation)
+*/
+
+#ifndef CONCURRENT_TREE_MAP_STATS_H
+#define CONCURRENT_TREE_MAP_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "PersistentTreeMapStats.h"
+
+// node of a ConcurrentTreeMapStats: adds whether the node is still private to the running write operation
+template <class K, class V, class Aggregate>
+class ConcurrentTreeMapStatsNode : public PathCopyingNodeBase<ConcurrentTreeMapStatsNode<K, V, Aggregate>, K, V, Aggregate> {
+  typedef PathCopyingNodeBase<ConcurrentTreeMapStatsNode, K, V, Aggregate> Base;
+
+public:
+  bool fresh;     // created by the running write operation, and not yet published (so still mutable)
+
+  ConcurrentTreeMapStatsNode(const K& k, const V& v) : Base(k, v), fresh(true) { };
+  ConcurrentTreeMapStatsNode(const ConcurrentTreeMapStatsNode& w) : Base(w), fresh(true) { };
+};
+
+/*
+# Purpose: Class definition of ConcurrentTreeMapStats, mapping keys of type K to values of type V using an AVL
+# tree whose nodes keep the Aggregate of their subtree (as BasicTreeMapStats), safe for concurrent use
+# NOTE: a published node is never modified: put and erase copy the nodes on the search path (and the nodes
+# moved by rotations; see PathCopyingTreeMapBase), link the copies into a new version of the tree, and publish
+# its root with a single atomic store; readers work on whichever version they loaded, so each query sees a
+# consistent tree
+# NOTE: writers are serialized by a mutex; readers take no lock and never wait for a writer
+# NOTE: reclamation: a reader announces the global epoch it started in, in its own slot, for the duration of
+# each query; the nodes replaced by a write are retired in the current epoch, and the epoch only advances
+# once every active reader has announced it; nodes retired in epoch e are freed once the epoch reaches e + 2
+# NOTE: the destructor and clear() free nodes immediately, so they must not run concurrently with readers
+*/
+template <class K, class V, class Aggregate = StatsAggregate<V>, class Compare = std::less<K> >
+class ConcurrentTreeMapStats :
+  public PathCopyingTreeMapBase<ConcurrentTreeMapStats<K, V, Aggregate, Compare>, ConcurrentTreeMapStatsNode<K, V, Aggregate>,
+                                K, V, Aggregate, Compare>
+{
+  typedef PathCopyingTreeMapBase<ConcurrentTreeMapStats, ConcurrentTreeMapStatsNode<K, V, Aggregate>, K, V, Aggregate, Compare> Base;
+  friend Base;
+
+public:
+  typedef ConcurrentTreeMapStatsNode<K, V, Aggregate> Node;
+  typedef typename Aggregate::type Info;
+
+  // maximum number of readers (threads holding a Reader) at any time
+  static const int MAX_READERS = 128;
+
+  /*
+  # Purpose: a registered reader of the map, holding a reader slot for its lifetime
+  # NOTE: a Reader must be used by one thread at a time; its queries never block
+  # NOTE: a thread claims the same slot again and again (see claimSlot), so a temporary Reader costs one
+  # uncontended compare-and-swap on a cache line of the thread's own; holding a Reader saves even that
+  */
+  class Reader {
+  public:
+    explicit Reader(const ConcurrentTreeMapStats& m) : map(m), slot(m.claimSlot()) { };
+    ~Reader() { map.slots[slot].used.store(false, std::memory_order_release); };
+
+    bool find(const K& k, V* v = NULL) const;
+    Info rangeStats(const K& lo, const K& hi) const;
+    Info stats() const;
+
+  private:
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    const ConcurrentTreeMapStats& map;
+    int slot;
+  };
+
+  // map constructors
+  ConcurrentTreeMapStats() : root(NULL), n(0), epoch(1), highSlot(0), retiredCount(0) { };
+  explicit ConcurrentTreeMapStats(const Compare& c) :
+    Base(c), root(NULL), n(0), epoch(1), highSlot(0), retiredCount(0) { };
+  // map destructor
+  ~ConcurrentTreeMapStats() { clear(); };
+
+  // updates (serialized among writers)
+  void put(const K& k, const V& v);
+  bool erase(const K& k);
+  void clear();
+
+  // queries, each through a temporary Reader (see Reader), which claims the slot of the calling thread
+  // OUTPUT: true iff key k is in the map, in which case its value is stored in *v (unless v is NULL)
+  bool find(const K& k, V* v = NULL) const { return Reader(*this).find(k, v); };
+  // OUTPUT: the aggregate of the map entries with keys in [lo, hi]
+  Info rangeStats(const K& lo, const K& hi) const { return Reader(*this).rangeStats(lo, hi); };
+  // OUTPUT: the aggregate of the whole map
+  Info stats() const { return Reader(*this).stats(); };
+  // OUTPUT: the number of map entries as of the last completed update
+  size_t size() const { return n.load(std::memory_order_relaxed); };
+  bool empty() const { return size() == 0; };
+
+private:
+  ConcurrentTreeMapStats(const ConcurrentTreeMapStats&) = delete;
+  ConcurrentTreeMapStats& operator=(const ConcurrentTreeMapStats&) = delete;
+
+  // a reader slot, on its own cache line: whether it is claimed by a Reader, and the epoch in which the
+  // query in progress started (0 if none)
+  struct alignas(64) Slot {
+    std::atomic<bool> used;
+    std::atomic<uint64_t> epoch;
+    Slot() : used(false), epoch(0) { };
+  };
+
+  // number of retired nodes after which a writer tries to advance the epoch
+  static const size_t RECLAIM_BATCH = 1024;
+
+  // data members: root of the current version of the tree; map size
+  std::atomic<Node*> root;
+  std::atomic<size_t> n;
+  // data members: global epoch; reader slots, and one past the highest slot ever claimed
+  std::atomic<uint64_t> epoch;
+  mutable Slot slots[MAX_READERS];
+  mutable std::atomic<int> highSlot;
+  // data members (writer only, guarded by writeLock): nodes created and nodes replaced by the running write
+  // operation; nodes retired in each of the last three epochs (indexed by epoch % 3); allocator for the nodes
+  std::mutex writeLock;
+  std::vector<Node*> created;
+  std::vector<Node*> replaced;
+  std::vector<Node*> retired[3];
+  size_t retiredCount;
+  NodePool pool;
+
+  // reader utilities
+  int claimSlot() const;
+  Node* enter(int slot) const;
+  void leave(int slot) const { slots[slot].epoch.store(0, std::memory_order_release); };
+
+  // hooks
+  Node* createNode(const K& k, const V& v) {
+    Node* w = new (pool.allocate(sizeof(Node))) Node(k, v);
+    created.push_back(w);
+    return w;
+  };
+  Node* mut(Node* w);
+  Node* removeNode(Node* w) { replaced.push_back(w); return w->left ? w->left : w->right; };
+
+  // writer utilities
+  void destroyNode(Node* w) { w->~Node(); pool.deallocate(w, sizeof(Node)); };
+  void publish(Node* r);
+  void tryAdvance();
+  void destroyAll(Node* w);
+};
+
+/*
+  # OUTPUT: the index of a reader slot, now claimed by the caller
+  # NOTE: the scan starts at the slot the calling thread claimed last (in any map; threads start at different
+  # slots, in turn), so as long as there are fewer readers than slots each thread keeps claiming its own
+  # slot, and readers do not contend on the slot cache lines
+  # NOTE: waits (yielding) while all MAX_READERS slots are claimed
+*/
+template <class K, class V, class A, class C>
+int
+ConcurrentTreeMapStats<K,V,A,C>::claimSlot() const {
+  static std::atomic<int> nextHint(0);
+  static thread_local int hint = nextHint.fetch_add(1, std::memory_order_relaxed) % MAX_READERS;
+  for (;;) {
+    for (int j = 0; j < MAX_READERS; j++) {
+      int i = (hint + j) % MAX_READERS;
+      bool expected = false;
+      if (!slots[i].used.load(std::memory_order_relaxed) && slots[i].used.compare_exchange_strong(expected, true)) {
+        int h = highSlot.load();
+        while (h <= i && !highSlot.compare_exchange_weak(h, i + 1)) { }
+        hint = i;
+        return i;
+      }
+    }
+    std::this_thread::yield();
+  }
+}
+
+/*
+  # INPUT: the index of a reader slot claimed by the caller
+  # OUTPUT: the root of the current version of the tree, which (with all its nodes) stays valid until leave(slot)
+  # NOTE: the epoch is announced before the root is loaded (both sequentially consistent): either a writer
+  # trying to advance the epoch sees the announcement, or this load sees every root published before that
+*/
+template <class K, class V, class A, class C>
+inline typename ConcurrentTreeMapStats<K,V,A,C>::Node*
+ConcurrentTreeMapStats<K,V,A,C>::enter(int slot) const {
+  slots[slot].epoch.store(epoch.load());
+  return root.load();
+}
+
+/*
+  # INPUT: a key k, and (optionally) a place v for its value
+  # OUTPUT: true iff key k is in the map, in which case its value is stored in *v (unless v is NULL)
+*/
+template <class K, class V, class A, class C>
+bool
+ConcurrentTreeMapStats<K,V,A,C>::Reader::find(const K& k, V* v) const {
+  const Node* w = map.findNode(map.enter(slot), k);
+  if (w && v) *v = w->value;
+  map.leave(slot);
+  return w != NULL;
+}
+
+/*
+  # INPUT: keys lo and hi, not necessarily in the map
+  # OUTPUT: the aggregate of the map entries with keys in [lo, hi] (the identity if there are none)
+*/
+template <class K, class V, class A, class C>
+typename ConcurrentTreeMapStats<K,V,A,C>::Info
+ConcurrentTreeMapStats<K,V,A,C>::Reader::rangeStats(const K& lo, const K& hi) const {
+  Info s = map.rangeInfo(map.enter(slot), lo, hi);
+  map.leave(slot);
+  return s;
+}
+
+// OUTPUT: the aggregate of the whole map (the identity if the map is empty)
+template <class K, class V, class A, class C>
+typename ConcurrentTreeMapStats<K,V,A,C>::Info
+ConcurrentTreeMapStats<K,V,A,C>::Reader::stats() const {
+  Info s = map.info(map.enter(slot));
+  map.leave(slot);
+  return s;
+}
+
+/*
+  # INPUT: a node w of the tree
+  # OUTPUT: w if it was created by the running write operation (so no reader can see it yet); otherwise a
+  # copy of w created by it, with w retired once the new version of the tree is published
+*/
+template <class K, class V, class A, class C>
+inline typename ConcurrentTreeMapStats<K,V,A,C>::Node*
+ConcurrentTreeMapStats<K,V,A,C>::mut(Node* w) {
+  if (w->fresh) return w;
+  Node* x = new (pool.allocate(sizeof(Node))) Node(*w);
+  created.push_back(x);
+  replaced.push_back(w);
+  return x;
+}
+
+/*
+  # INPUT: the root r of the new version of the tree, built by the running write operation
+  # POSTCONDITION: r is the current root; the nodes created by the operation are no longer mutable, and the
+  # nodes replaced by it are retired in the current epoch
+*/
+template <class K, class V, class A, class C>
+void
+ConcurrentTreeMapStats<K,V,A,C>::publish(Node* r) {
+  for (size_t i = 0; i < created.size(); i++) created[i]->fresh = false;
+  created.clear();
+  root.store(r);
+  std::vector<Node*>& bin = retired[epoch.load(std::memory_order_relaxed) % 3];
+  bin.insert(bin.end(), replaced.begin(), replaced.end());
+  retiredCount += replaced.size();
+  replaced.clear();
+  if (retiredCount >= RECLAIM_BATCH) tryAdvance();
+}
+
+/*
+  # POSTCONDITION: if every active reader started in the current epoch e, the epoch is advanced to e + 1 and
+  # the nodes retired in epoch e - 1 are freed (no reader can still reach them: every query that could have
+  # loaded a root older than their removal started before epoch e)
+*/
+template <class K, class V, class A, class C>
+void
+ConcurrentTreeMapStats<K,V,A,C>::tryAdvance() {
+  uint64_t e = epoch.load(std::memory_order_relaxed);
+  int h = highSlot.load();
+  for (int i = 0; i < h; i++) {
+    uint64_t s = slots[i].epoch.load();
+    if (s && s != e) return;
+  }
+  epoch.store(e + 1);
+  std::vector<Node*>& bin = retired[(e + 2) % 3];
+  for (size_t i = 0; i < bin.size(); i++) destroyNode(bin[i]);
+  retiredCount -= bin.size();
+  bin.clear();
+}
+
+/*
+  # INPUT: a key-value pair k and v
+  # POSTCONDITION: the current version of the tree maps k to v
+*/
+template <class K, class V, class A, class C>
+void
+ConcurrentTreeMapStats<K,V,A,C>::put(const K& k, const V& v) {
+  std::lock_guard<std::mutex> lock(writeLock);
+  bool added = false;
+  publish(this->putAux(root.load(std::memory_order_relaxed), k, v, added));
+  if (added) n.store(n.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+/*
+  # INPUT: a key k
+  # OUTPUT: true iff k was in the map
+  # POSTCONDITION: the current version of the tree does not contain k
+*/
+template <class K, class V, class A, class C>
+bool
+ConcurrentTreeMapStats<K,V,A,C>::erase(const K& k) {
+  std::lock_guard<std::mutex> lock(writeLock);
+  Node* r = root.load(std::memory_order_relaxed);
+  if (!this->findNode(r, k)) return false;
+  publish(this->eraseAux(r, k));
+  n.store(n.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+  return true;
+}
+
+// POSTCONDITION: the subtree rooted at w has its nodes destroyed, in postorder
+template <class K, class V, class A, class C>
+void
+ConcurrentTreeMapStats<K,V,A,C>::destroyAll(Node* w) {
+  eulerTour(w, [](Node* x, TourStep step, int) { if (step == TOUR_POST) x->~Node(); });
+}
+
+/*
+  # POSTCONDITION: the map is empty; every node (current or retired) is freed and the node pool released
+  # PRECONDITION: no query is in progress
+*/
+template <class K, class V, class A, class C>
+void
+ConcurrentTreeMapStats<K,V,A,C>::clear() {
+  std::lock_guard<std::mutex> lock(writeLock);
+  for (int i = 0; i < 3; i++) {
+    if (!std::is_trivially_destructible<Node>::value)
+      for (size_t j = 0; j < retired[i].size(); j++) retired[i][j]->~Node();
+    retired[i].clear();
+  }
+  if (!std::is_trivially_destructible<Node>::value) destroyAll(root.load());
+  root.store(NULL);
+  n.store(0, std::memory_order_relaxed);
+  retiredCount = 0;
+  pool.release();
+}
+
+#endif // CONCURRENT_TREE_MAP_STATS_H
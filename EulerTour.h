@@ -0,0 +1,72 @@
+/*
+# Purpose: Iterative Euler tour of a binary tree, shared by the print and teardown utilities of all the maps
+# (BSTMap and its subclasses, and the templated maps)
+*/
+
+#ifndef EULER_TOUR_H
+#define EULER_TOUR_H
+
+#include <cstddef>
+#include <vector>
+
+// the three visits of a node in an Euler tour
+enum TourStep { TOUR_PRE, TOUR_IN, TOUR_POST };
+
+/*
+  # INPUT: the root s of a subtree, given as a node handle of type H (a pointer, or an index into a node array),
+  # and the handle nil of the empty subtree; functions first(w) and second(w) returning the children of a node,
+  # in the order of the tour (the left child first, or the right child first for a mirrored tour); a visitor
+  # function visit(w, step, depth)
+  # POSTCONDITION: every node w in the subtree has been visited three times, in an Euler tour of the subtree:
+  # with step TOUR_PRE before its first subtree, TOUR_IN between its subtrees, and TOUR_POST after its second
+  # subtree; depth is the distance from s to w
+  # NOTE: the path from s to the current node is kept on an explicit (heap-allocated) stack instead of the call
+  # stack, so the depth of the tree is not limited by the call stack (an unbalanced BST may degenerate into a
+  # list); the second child of each node on the path is read at its TOUR_PRE visit, so a node is not read again
+  # after that (unless by visit itself), and visit may destroy the node at its TOUR_POST step
+*/
+template <class H, class First, class Second, class Visit>
+void eulerTour(H s, H nil, First first, Second second, Visit visit) {
+  struct Frame {
+    H w;
+    H second;
+    bool between;  // true iff the TOUR_IN visit of w has been done
+  };
+  std::vector<Frame> path;
+  path.reserve(64);
+  H w = s;
+  while (true) {
+    // go down along first children as far as possible
+    while (w != nil) {
+      visit(w, TOUR_PRE, (int) path.size());
+      path.push_back({w, second(w), false});
+      w = first(w);
+    }
+    // go back up past every node whose second subtree is done
+    while (!path.empty() && path.back().between) {
+      w = path.back().w;
+      path.pop_back();
+      visit(w, TOUR_POST, (int) path.size());
+    }
+    if (path.empty()) break;
+    // the first subtree of the node on top is done: visit it in between, then go down its second subtree
+    Frame& f = path.back();
+    visit(f.w, TOUR_IN, (int) path.size() - 1);
+    f.between = true;
+    w = f.second;
+  }
+}
+
+// (Euler tour of the subtree rooted at node s, for nodes linked by pointers named left and right)
+template <class N, class Visit>
+inline void eulerTour(N* s, Visit visit) {
+  eulerTour(s, (N*) NULL, [](N* w) -> N* { return w->left; }, [](N* w) -> N* { return w->right; }, visit);
+}
+
+// (the same, mirrored: the right subtree of each node is toured before its left subtree)
+template <class N, class Visit>
+inline void mirroredEulerTour(N* s, Visit visit) {
+  eulerTour(s, (N*) NULL, [](N* w) -> N* { return w->right; }, [](N* w) -> N* { return w->left; }, visit);
+}
+
+#endif // EULER_TOUR_H
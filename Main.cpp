@@ -8,28 +8,518 @@
 # Purpose: Modified code for simple int-to-int (from int-to-string) order map ADT Implementation on linked-structured BSTs
 */
 
-#include <iostream>
 #include <cstdlib>
 #include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <cstdint>
+#include <climits>
 #include <string>
-#include <fstream>
+#include <string_view>
+#include <charconv>
 #include <cstddef>
+#include <iterator>
 #include <vector>
-#include <sstream>
 #include <algorithm>
+#include <new>
+#include <utility>
+#include <memory>
+#include <typeinfo>
+#include <thread>
+#include <chrono>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "EulerTour.h"
+#include "NodePool.h"
 
 using namespace std;
 
 // Utility functions
-void loadFile(string fname, fstream& file)
+
+/*
+# Purpose: Class definition of OutputSink, a buffered writer used for all the output of the maps and the driver
+# NOTE: output is collected in a large buffer and only written to the underlying file when the buffer is full,
+# when flush() is called explicitly, or when the sink is destroyed; integers are formatted in place with to_chars
+*/
+class OutputSink
 {
-  file.open(fname.c_str());
-  if (file.fail())
+
+public:
+  OutputSink(FILE* f) : file(f), buf(BUFFER_SIZE), len(0) { };
+  ~OutputSink() { flush(); };
+
+  void write(const char* s, size_t n);
+  void flush();
+
+  // output operators
+  OutputSink& operator<<(char c) {
+    if (len == buf.size()) writeBuffer();
+    buf[len++] = c;
+    return *this;
+  };
+  OutputSink& operator<<(const char* s) { write(s, strlen(s)); return *this; };
+  OutputSink& operator<<(string_view s) { write(s.data(), s.size()); return *this; };
+  OutputSink& operator<<(int v) { return writeInt(v); };
+  OutputSink& operator<<(long long v) { return writeInt(v); };
+
+private:
+  OutputSink(const OutputSink&) = delete;
+  OutputSink& operator=(const OutputSink&) = delete;
+
+  static const size_t BUFFER_SIZE = 1 << 20;
+  static const size_t MAX_INT_CHARS = 24;
+
+  // data members: output file; write buffer; number of bytes in the buffer
+  FILE* file;
+  vector<char> buf;
+  size_t len;
+
+  // auxiliary utilities
+  void writeBuffer();
+  template <class T> OutputSink& writeInt(T v) {
+    if (buf.size() - len < MAX_INT_CHARS) writeBuffer();
+    len = to_chars(buf.data() + len, buf.data() + buf.size(), v).ptr - buf.data();
+    return *this;
+  };
+};
+
+// POSTCONDITION: the contents of the buffer have been handed to the file (without flushing the file itself)
+void
+OutputSink::writeBuffer() {
+  if (len) fwrite(buf.data(), 1, len, file);
+  len = 0;
+}
+
+// POSTCONDITION: n bytes starting at s have been appended to the output
+void
+OutputSink::write(const char* s, size_t n) {
+  if (buf.size() - len < n) {
+    writeBuffer();
+    // too large for the buffer: write it out directly
+    if (n >= buf.size()) {
+      fwrite(s, 1, n, file);
+      return;
+    }
+  }
+  memcpy(buf.data() + len, s, n);
+  len += n;
+}
+
+// POSTCONDITION: all output so far has been written out to the file
+void
+OutputSink::flush() {
+  writeBuffer();
+  fflush(file);
+}
+
+// OUTPUT: the default output sink, on the standard output (flushed at program exit)
+OutputSink& defaultOutput()
+{
+  static OutputSink sink(stdout);
+  return sink;
+}
+
+/*
+# Purpose: Class definition of CommandReader, a reader of the lines of a (command) file
+# NOTE: the file is read in large chunks into a single buffer, and each line is handed out as a view into
+# that buffer, valid until the next call; no memory is allocated per line (the buffer only grows if a
+# single line does not fit in it)
+*/
+class CommandReader
+{
+
+public:
+  CommandReader(const string& fname);
+  ~CommandReader() { if (file) fclose(file); };
+
+  bool nextLine(string_view& line);
+
+private:
+  CommandReader(const CommandReader&) = delete;
+  CommandReader& operator=(const CommandReader&) = delete;
+
+  static const size_t BUFFER_SIZE = 1 << 20;
+
+  // data members: input file; read buffer; unread part of the buffer [begin, end); end of file reached
+  FILE* file;
+  vector<char> buf;
+  size_t begin;
+  size_t end;
+  bool eof;
+};
+
+CommandReader::CommandReader(const string& fname) :
+  file(fopen(fname.c_str(), "rb")), buf(BUFFER_SIZE), begin(0), end(0), eof(false)
+{
+  if (!file)
     {
-      cout << "Cannot open file " << fname << endl;
+      defaultOutput() << "Cannot open file " << fname << '\n';
     }
 }
-  
+
+/*
+  # OUTPUT: false if there are no more lines; otherwise true, with line set to the next line of the file
+  # (without its end of line character)
+*/
+bool
+CommandReader::nextLine(string_view& line) {
+  if (!file) return false;
+  while (true) {
+    const char* b = buf.data() + begin;
+    const char* nl = (const char*) memchr(b, '\n', end - begin);
+    if (nl) {
+      line = string_view(b, nl - b);
+      begin = nl - buf.data() + 1;
+      return true;
+    }
+    if (eof) {
+      // last line, not terminated by an end of line character
+      if (begin == end) return false;
+      line = string_view(b, end - begin);
+      begin = end;
+      return true;
+    }
+    // move the partial line to the front of the buffer (growing it if the line fills it) and read more
+    size_t rest = end - begin;
+    memmove(buf.data(), b, rest);
+    begin = 0;
+    end = rest;
+    if (end == buf.size()) buf.resize(2 * buf.size());
+    size_t got = fread(buf.data() + end, 1, buf.size() - end, file);
+    end += got;
+    if (got == 0) eof = true;
+  }
+}
+
+/*
+  # INPUT: the unparsed rest s of a line
+  # OUTPUT: the next whitespace-separated token in s (empty if there is none)
+  # POSTCONDITION: s is the rest of the line after the token
+*/
+string_view nextToken(string_view& s)
+{
+  size_t b = 0;
+  while (b < s.size() && isspace((unsigned char) s[b])) b++;
+  size_t e = b;
+  while (e < s.size() && !isspace((unsigned char) s[e])) e++;
+  string_view token = s.substr(b, e - b);
+  s.remove_prefix(e);
+  return token;
+}
+
+/*
+  # INPUT: the unparsed rest s of a line
+  # OUTPUT: true iff the next token in s is an integer in the range of int, which is then stored in v
+  # POSTCONDITION: s is the rest of the line after the token
+*/
+bool nextInt(string_view& s, int& v)
+{
+  string_view token = nextToken(s);
+  // from_chars takes no plus sign (and must not see a minus sign after one)
+  if (!token.empty() && token[0] == '+') {
+    token.remove_prefix(1);
+    if (!token.empty() && token[0] == '-') return false;
+  }
+  const char* e = token.data() + token.size();
+  from_chars_result r = from_chars(token.data(), e, v);
+  return !token.empty() && r.ec == errc() && r.ptr == e;
+}
+
+// commands of the driver program
+enum Command {
+  CMD_UNKNOWN, CMD_PUT, CMD_ERASE, CMD_ERASE_RANGE, CMD_FIND, CMD_SIZE, CMD_SELECT, CMD_RANK, CMD_MEDIAN, CMD_RANGE_STATS, CMD_SCAN,
+  CMD_NODE_VISITS, CMD_PRINT, CMD_PRINT_STATS, CMD_PRINT_TREE, CMD_PRINT_STATS_TREE, CMD_PRINT_KEY_STATS, CMD_NOECHO,
+  CMD_FLUSH, CMD_SAVE, CMD_LOAD, CMD_WAL, CMD_CHECKPOINT, CMD_RECOVER
+};
+
+// OUTPUT: the command named by token c (CMD_UNKNOWN if there is none), dispatching on its length first
+Command parseCommand(string_view c)
+{
+  switch (c.size()) {
+  case 3:
+    if (c == "put") return CMD_PUT;
+    if (c == "wal") return CMD_WAL;
+    break;
+  case 4:
+    if (c == "find") return CMD_FIND;
+    if (c == "size") return CMD_SIZE;
+    if (c == "rank") return CMD_RANK;
+    if (c == "scan") return CMD_SCAN;
+    if (c == "save") return CMD_SAVE;
+    if (c == "load") return CMD_LOAD;
+    break;
+  case 5:
+    if (c == "erase") return CMD_ERASE;
+    if (c == "print") return CMD_PRINT;
+    if (c == "flush") return CMD_FLUSH;
+    break;
+  case 6:
+    if (c == "select") return CMD_SELECT;
+    if (c == "median") return CMD_MEDIAN;
+    if (c == "noecho") return CMD_NOECHO;
+    break;
+  case 7:
+    if (c == "recover") return CMD_RECOVER;
+    break;
+  case 10:
+    if (c == "print_tree") return CMD_PRINT_TREE;
+    if (c == "checkpoint") return CMD_CHECKPOINT;
+    break;
+  case 11:
+    if (c == "print_stats") return CMD_PRINT_STATS;
+    if (c == "range_stats") return CMD_RANGE_STATS;
+    if (c == "node_visits") return CMD_NODE_VISITS;
+    if (c == "erase_range") return CMD_ERASE_RANGE;
+    break;
+  case 15:
+    if (c == "print_key_stats") return CMD_PRINT_KEY_STATS;
+    break;
+  case 16:
+    if (c == "print_stats_tree") return CMD_PRINT_STATS_TREE;
+    break;
+  }
+  return CMD_UNKNOWN;
+}
+
+/*
+# Purpose: Binary snapshot format of the maps (see BSTMap::saveSnapshot and BSTMap::loadSnapshot)
+# NOTE: a snapshot file holds a 16-byte header (the 8-byte magic "MAPSNAP1", then the number of entries m as a
+# 64-bit integer), the m map entries in increasing order of keys, each as two 32-bit integers (key, then
+# value), and a trailing 64-bit checksum of the entries (see SnapshotChecksum); all integers are little-endian
+*/
+const char SNAPSHOT_MAGIC[8] = { 'M', 'A', 'P', 'S', 'N', 'A', 'P', '1' };
+const size_t SNAPSHOT_HEADER_BYTES = 16;
+const size_t SNAPSHOT_ENTRY_BYTES = 8;
+const size_t SNAPSHOT_TRAILER_BYTES = 8;
+const size_t SNAPSHOT_BUFFER_BYTES = 1 << 20;
+
+// little-endian encoding/decoding of an unsigned integer x of the given number of bytes at p
+inline void putLE(char* p, uint64_t x, int bytes) {
+  for (int i = 0; i < bytes; i++) p[i] = (char) (x >> (8 * i));
+}
+inline uint64_t getLE(const char* p, int bytes) {
+  uint64_t x = 0;
+  for (int i = 0; i < bytes; i++) x |= (uint64_t) (unsigned char) p[i] << (8 * i);
+  return x;
+}
+
+/*
+# Purpose: Class definition of SnapshotChecksum, the checksum of the entries of a snapshot
+# NOTE: each entry, as a 64-bit word, is mixed into the running sum by a rotation and a multiplication by an
+# odd constant; every step is a bijection of the running sum, so a single corrupted entry always changes
+# the result, and the rotation carries high bits back down so that later entries mix with all of them
+*/
+class SnapshotChecksum
+{
+
+public:
+  SnapshotChecksum() : h(0x9e3779b97f4a7c15ULL) { };
+
+  void add(int k, int v) {
+    uint64_t x = h ^ ((uint64_t) (uint32_t) k | ((uint64_t) (uint32_t) v << 32));
+    h = ((x << 29) | (x >> 35)) * 0xff51afd7ed558ccdULL;
+  };
+  uint64_t value() const { return h; };
+
+private:
+  uint64_t h;
+};
+
+/*
+# Purpose: Class definition of RecordReader, a buffered reader of the fixed-size records of a snapshot or log file
+*/
+class RecordReader
+{
+
+public:
+  RecordReader(FILE* f) : file(f), buf(SNAPSHOT_BUFFER_BYTES), begin(0), end(0) { };
+
+  // OUTPUT: a pointer to the next m bytes of the file (valid until the next call), or NULL if there are fewer
+  const char* next(size_t m) {
+    if (end - begin < m) {
+      memmove(buf.data(), buf.data() + begin, end - begin);
+      end -= begin;
+      begin = 0;
+      end += fread(buf.data() + end, 1, buf.size() - end, file);
+      if (end < m) return NULL;
+    }
+    const char* p = buf.data() + begin;
+    begin += m;
+    return p;
+  };
+
+private:
+  RecordReader(const RecordReader&) = delete;
+  RecordReader& operator=(const RecordReader&) = delete;
+
+  // data members: snapshot or log file; read buffer; unread part of the buffer [begin, end)
+  FILE* file;
+  vector<char> buf;
+  size_t begin;
+  size_t end;
+};
+
+/*
+  # INPUT: the path of a file
+  # OUTPUT: true iff the directory holding the file was synced to disk (making a rename into it durable)
+*/
+bool syncDirectory(const string& path)
+{
+  size_t slash = path.find_last_of('/');
+  string dir = (slash == string::npos) ? "." : (slash == 0) ? "/" : path.substr(0, slash);
+  int fd = ::open(dir.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  bool ok = fsync(fd) == 0;
+  ::close(fd);
+  return ok;
+}
+
+class BSTMap;
+class AVLTreeMap;
+
+/*
+# Purpose: Class definition of WriteAheadLog, an append-only binary log of the updates of a map, for crash recovery
+# NOTE: a map with a log attached (see BSTMap::setLog) appends a record of each put, erase, eraseRange and
+# applyBatch update to the log before applying it; each record is written to the log file at once, so it
+# survives a crash of the process, but the file is synced to disk in groups: as soon as groupRecords records
+# are pending, or a record is appended groupMillis milliseconds or more after the oldest pending one (if
+# groupMillis is positive), and whenever commit() is called; a crash of the system loses at most the updates
+# pending commit
+# NOTE: there is no timer: the records pending commit when the updates stop stay unsynced until the next
+# append, commit() or close(), so a caller that uses groupMillis should commit when it goes idle
+# NOTE: each record is 16 bytes: its type as a 32-bit integer, the key (or lo) and the value (or hi), and a
+# 32-bit checksum of the first 12 bytes, all little-endian; recovery stops at the first incomplete or invalid
+# record, which is where a crash may have cut the log short
+# NOTE: checkpoint() saves a snapshot and empties the log; recover() loads the latest snapshot and replays the
+# log; since each update only overwrites or removes entries, replaying records whose updates are already in
+# the snapshot (after a crash in the middle of a checkpoint) leaves the same map
+# NOTE: updates that are not recorded (split, join, set operations, bulk loads, snapshot loads and clear())
+# checkpoint the log instead, once applied; a log is attached to at most one map
+*/
+class WriteAheadLog
+{
+
+public:
+  enum RecordType { PUT = 1, ERASE = 2, ERASE_RANGE = 3 };
+
+  // log constructor (not open); by default, every record is committed on its own
+  WriteAheadLog(int records = 1, int millis = 0) : fd(-1), groupRecords(records), groupMillis(millis), pending(0), failed(false) { };
+  // log destructor (commits the pending records)
+  ~WriteAheadLog() { close(); };
+
+  bool open(const string& logPath, const string& snapshotPath);
+  bool close();
+  bool isOpen() const { return fd >= 0; };
+  // OUTPUT: false once a write or sync of the log, or a checkpoint, has failed
+  bool good() const { return !failed; };
+  void setGroupCommit(int records, int millis) { groupRecords = records; groupMillis = millis; };
+
+  bool append(RecordType type, int k, int v);
+  bool commit();
+  bool checkpoint(const BSTMap& map);
+  static bool recover(AVLTreeMap& map, const string& snapshotPath, const string& logPath);
+
+private:
+  WriteAheadLog(const WriteAheadLog&) = delete;
+  WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+  static const size_t RECORD_BYTES = 16;
+
+  // data members: log file descriptor; path of the snapshot that checkpoints save; group commit limits;
+  // number of records written but not synced yet, and the time the oldest of them was appended; whether a
+  // write, sync or checkpoint has failed
+  int fd;
+  string snapshot;
+  int groupRecords;
+  int groupMillis;
+  int pending;
+  chrono::steady_clock::time_point oldest;
+  bool failed;
+
+  // OUTPUT: the checksum of the first 12 bytes of the record at p (FNV-1a)
+  static uint32_t check(const char* p) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < 12; i++) h = (h ^ (unsigned char) p[i]) * 16777619u;
+    return h;
+  };
+};
+
+/*
+  # INPUT: the path of a log file, and the path of the snapshot file that goes with it
+  # OUTPUT: true iff the log file was opened (created if needed) for appending records, after any log open
+  # before is closed
+  # NOTE: the log only describes a map together with the snapshot: attach the log to the map (see
+  # BSTMap::setLog) only after recovering the map from both (see recover), since attaching checkpoints it
+*/
+bool
+WriteAheadLog::open(const string& logPath, const string& snapshotPath) {
+  close();
+  fd = ::open(logPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  snapshot = snapshotPath;
+  failed = false;
+  return fd >= 0;
+}
+
+/*
+  # OUTPUT: true iff the pending records were committed
+  # POSTCONDITION: the log is closed
+*/
+bool
+WriteAheadLog::close() {
+  if (fd < 0) return true;
+  bool ok = commit();
+  ::close(fd);
+  fd = -1;
+  return ok;
+}
+
+/*
+  # INPUT: the type of an update, and its key and value (or range)
+  # OUTPUT: false iff the log is not open, or a write or commit failed (now or before)
+  # POSTCONDITION: a record of the update is written to the log file and pending commit, and it is committed
+  # (with all the other pending records) if the group is complete
+*/
+inline bool
+WriteAheadLog::append(RecordType type, int k, int v) {
+  if (fd < 0 || failed) return false;
+  char p[RECORD_BYTES];
+  putLE(p, type, 4);
+  putLE(p + 4, (uint32_t) k, 4);
+  putLE(p + 8, (uint32_t) v, 4);
+  putLE(p + 12, check(p), 4);
+  size_t done = 0;
+  while (!failed && done < RECORD_BYTES) {
+    ssize_t w = ::write(fd, p + done, RECORD_BYTES - done);
+    if (w < 0 && errno != EINTR) failed = true;
+    if (w > 0) done += w;
+  }
+  if (failed) return false;
+  if (groupMillis > 0) {
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (pending == 0) oldest = now;
+    else if (now - oldest >= chrono::milliseconds(groupMillis)) pending = groupRecords;
+  }
+  if (++pending >= groupRecords) return commit();
+  return true;
+}
+
+/*
+  # OUTPUT: true iff all the records appended so far are on disk
+  # POSTCONDITION: the log file is synced, if any records are pending (one sync per group)
+*/
+bool
+WriteAheadLog::commit() {
+  if (fd < 0) return false;
+  if (pending == 0) return !failed;
+  if (!failed && fdatasync(fd) != 0) failed = true;
+  pending = 0;
+  return !failed;
+}
+
 /*
 # Purpose: Class definition of a simple implementation of an ordered map ADT, 
 # mapping integers keys to integer values, using a binary search tree (BST) with a linked-structure representation
@@ -61,24 +551,61 @@ public:
     // node desctructor
     virtual ~Node() {};
 
-    // overloading output stream for a representation of BST node w
-    friend ostream& operator<<(ostream& os, const Node& w) {
-      os << w.key << ":" << w.value ; 
+    // overloading output sink operator for a representation of BST node w
+    friend OutputSink& operator<<(OutputSink& os, const Node& w) {
+      os << w.key << ':' << w.value ; 
       return os;
     };
 
     // (overloadable) print node stats
-    virtual void printStats() { cout << *this; };
+    virtual void printStats(OutputSink& os) { os << *this; };
     
   };
 
   // prints a representation of BST node w
   // (overloadable)
   // INPUT: node w
-  virtual void printNode(const Node* w) const { if (w) cout << *((Node*) w); };
+  virtual void printNode(const Node* w) const { if (w) *out << *((Node*) w); };
 
-  // tree constructor
-  BSTMap() : root(NULL), n(0) { };
+  // bidirectional iterator over the nodes of the BST (that is, the map entries) in increasing order of keys,
+  // built on successor/predecessor; end() is represented by NULL, and decrementing it yields the last node
+  // NOTE: an iterator is invalidated by any put of a new key or erase on the map (erase may move
+  // the entry of a node into another node), but not by a put that only updates a value
+  class iterator {
+  public:
+    typedef bidirectional_iterator_tag iterator_category;
+    typedef Node value_type;
+    typedef ptrdiff_t difference_type;
+    typedef Node* pointer;
+    typedef Node& reference;
+
+    iterator() : map(NULL), w(NULL) { };
+    iterator(const BSTMap* m, Node* x) : map(m), w(x) { };
+
+    Node& operator*() const { return *w; };
+    Node* operator->() const { return w; };
+    // the current node, or NULL at end()
+    Node* node() const { return w; };
+
+    iterator& operator++() { w = map->successor(w); return *this; };
+    iterator operator++(int) { iterator i = *this; ++*this; return i; };
+    iterator& operator--() {
+      w = w ? map->predecessor(w) : map->youngestDescendantType(map->root, false);
+      return *this;
+    };
+    iterator operator--(int) { iterator i = *this; --*this; return i; };
+
+    bool operator==(const iterator& i) const { return w == i.w; };
+    bool operator!=(const iterator& i) const { return w != i.w; };
+
+  private:
+    const BSTMap* map;
+    Node* w;
+  };
+
+  // tree constructors
+  BSTMap() : root(NULL), out(&defaultOutput()), wal(NULL), pool(make_shared<NodePool>()), n(0) { };
+  BSTMap(const vector<pair<int,int> >& entries, bool sorted = false) : root(NULL), out(&defaultOutput()), wal(NULL), pool(make_shared<NodePool>()), n(0) { bulkLoad(entries, sorted); };
   // tree destructor
   virtual ~BSTMap();
 
@@ -88,6 +615,27 @@ public:
   void erase(int k);
   int size() const;
   bool empty() const;
+  void clear();
+  void bulkLoad(const vector<pair<int,int> >& entries, bool sorted = false);
+  // binary snapshots (see the snapshot format above)
+  bool saveSnapshot(const string& path) const;
+  bool loadSnapshot(const string& path);
+  // ordered iteration
+  iterator begin() const { return iterator(this, youngestDescendantType(root, true)); };
+  iterator end() const { return iterator(this, NULL); };
+  iterator lower_bound(int k) const;
+  iterator upper_bound(int k) const;
+  pair<iterator,iterator> equal_range(int k) const;
+  // range scans
+  template <class Visit> int scan(int lo, int hi, int limit, Visit visit) const;
+  int printRange(int lo, int hi, int limit = -1) const;
+  // output sink used by all the print utilities (the default output sink unless set otherwise)
+  OutputSink& output() const { return *out; };
+  void setOutput(OutputSink& os) { out = &os; };
+  // write-ahead log that the updates are recorded to (none unless set otherwise; see WriteAheadLog); attaching
+  // a log checkpoints it, so that its snapshot and records describe the map from then on
+  WriteAheadLog* getLog() const { return wal; };
+  void setLog(WriteAheadLog* log) { wal = log; checkpointLog(); };
   // auxiliary utilities
   Node* youngestAncestorType(Node* w, bool check_left) const;
   Node* youngestDescendantType(Node* w, bool check_left) const;
@@ -103,9 +651,20 @@ protected:
 
   // data member: tree root node
   Node* root;
-
-  // (overloadable) auxiliary node creation utility
-  virtual Node* createNode(int k, int v, Node* l, Node* r, Node* p) { return new Node(k,v,l,r,p); };
+  // data member: output sink for all the print utilities
+  OutputSink* out;
+  // data member: write-ahead log of the updates, or NULL
+  WriteAheadLog* wal;
+  // checkpoint of the write-ahead log, if any, after an update that is not recorded to it (see WriteAheadLog)
+  void checkpointLog() const { if (wal) wal->checkpoint(*this); };
+
+  // data member: allocator for all the nodes of the tree (shared with the maps that nodes are moved to or
+  // from, see sharePool)
+  shared_ptr<NodePool> pool;
+
+  // (overloadable) auxiliary node creation/destruction utilities; nodes live in the tree's node pool
+  virtual Node* createNode(int k, int v, Node* l, Node* r, Node* p) { return new (pool->allocate(sizeof(Node))) Node(k,v,l,r,p); };
+  virtual void destroyNode(Node* w) { w->~Node(); pool->deallocate(w, sizeof(Node)); };
   
   // auxiliary print utilities
   void printAux(const Node* w, bool simple) const;  // print utility
@@ -114,9 +673,20 @@ protected:
   // auxiliary utilities
   void makeChild(Node* p, Node* c, bool isLeft);
   Node* findNode(int k) const;
+  Node* buildTree(const vector<pair<int,int> >& entries, int lo, int hi);
+  template <class Next> Node* buildTree(int m, Next& next);
   virtual Node* putNode(int k, int v);
   virtual Node* eraseNode(int k);
 
+  // node transfer utilities (subtrees are moved between maps by relinking them, so the maps must share
+  // their node pool)
+  void sharePool(BSTMap& other);
+  Node* detachNode(Node* w);
+  void setTree(Node* r, int m) { root = r; n = m; };
+  int destroySubtree(Node* w);
+  // (overloadable) number of nodes in the subtree rooted at w
+  virtual int subtreeSize(const Node* w) const;
+
 private:
   // auxiliary utilities
   virtual void deleteNode(Node* w);
@@ -131,6 +701,43 @@ private:
  *Purpose: Implement member functions/methods of BSTMap class 
  */
 
+/*
+  # INPUT: keys lo and hi (as integers), not necessarily in the map; the maximum number of entries to visit,
+  # limit (no maximum if negative); a visitor function visit(w)
+  # OUTPUT: the number of nodes visited
+  # POSTCONDITION: visit has been called, in increasing order of keys, on the first (at most limit) nodes of
+  # the BST with keys in [lo, hi]
+  # NOTE: O(log n + k) for k nodes visited: a single search for lo, then a walk along successors
+*/
+template <class Visit>
+int
+BSTMap::scan(int lo, int hi, int limit, Visit visit) const {
+  int count = 0;
+  for (iterator i = lower_bound(lo); (i != end()) && (i->key <= hi) && (count != limit); ++i) {
+    visit(i.node());
+    count++;
+  }
+  return count;
+}
+
+/*
+  # INPUT: keys lo and hi, and limit, as for scan
+  # OUTPUT: the number of entries printed
+  # POSTCONDITION: the key-value pairs of the entries visited by scan are printed out on a single line,
+  # separated by spaces
+*/
+int
+BSTMap::printRange(int lo, int hi, int limit) const {
+  bool first = true;
+  int count = scan(lo, hi, limit, [this, &first](const BSTMap::Node* w) {
+    if (!first) *out << ' ';
+    *out << *w;
+    first = false;
+  });
+  *out << '\n';
+  return count;
+}
+
 /*
   # utility/aux function to print out a parenthetic string representation of the BST
   # INPUT: a node w in the BST (or subclass) whose subtree is to be
@@ -140,27 +747,27 @@ private:
   # characteristics of a subclass object
 */
 void BSTMap::printAux(const BSTMap::Node* w, bool simple) const {
-  if (w) {
-    if (simple)
-      cout << "[" << *w << "]";
-    else {
-      cout << "[";
-      printNode(w);
-      cout << "]";
+  eulerTour((BSTMap::Node*) w, [this, simple](BSTMap::Node* x, TourStep step, int) {
+    if (step == TOUR_PRE) {
+      if (simple)
+	*out << '[' << *x << ']';
+      else {
+	*out << '[';
+	printNode(x);
+	*out << ']';
+      }
+      *out << '(';
     }
-    cout << "(";
-    printAux(w->left, simple);
-    cout << "),(";
-    printAux(w->right, simple);
-    cout << ")";
-  }
+    else if (step == TOUR_IN) *out << "),(";
+    else *out << ')';
+  });
 }
 
 // print out a parenthetic string representation of the whole BST
 void
 BSTMap::print() const {
   printAux(root, false);
-  cout << endl;
+  *out << '\n';
 }
 
 // print out a parenthetic string representation of the whole BST
@@ -168,7 +775,7 @@ BSTMap::print() const {
 void
 BSTMap::printMap() const {
   printAux(root, true);
-  cout << endl;
+  *out << '\n';
 }
 
 /*
@@ -185,25 +792,16 @@ BSTMap::printMap() const {
 void
 BSTMap::printTreeAux(BSTMap::Node* s, int space, bool simple) const {
   int addSpace = 8;
-  // base case
-  if (!s)
-    {
-      return;
-    }
-  // add more whitespace
-  space = space + addSpace;
-  // print right
-  printTreeAux(s->right, space, simple);
-
-  cout << endl;
-  for (int i = addSpace; i < space; i++)
-    cout << " ";
-  if (simple) cout << *s;
-  else printNode(s);
-  cout << endl;
-
-  // print left
-  printTreeAux(s->left, space, simple);
+  // reverse inorder traversal: print each node between its right and left subtrees, indented by its depth
+  mirroredEulerTour(s, [this, space, addSpace, simple](BSTMap::Node* x, TourStep step, int depth) {
+    if (step != TOUR_IN) return;
+    *out << '\n';
+    for (int i = 0; i < space + depth * addSpace; i++)
+      *out << ' ';
+    if (simple) *out << *x;
+    else printNode(x);
+    *out << '\n';
+  });
 }
 
 // print tree-like layout of the whole BST
@@ -247,63 +845,319 @@ BSTMap::deleteNode(BSTMap::Node* w)
 {
   if (w) {
     BSTMap::Node* z = w->parent;
-    // recursively delete children
-    deleteNode(w->left);
-    deleteNode(w->right);
+    // detach the subtree, then delete its nodes in postorder
     if (z) {
       if (z->left == w) z->left = NULL;
       else z->right = NULL;
     }
-    delete w;
-    n--;
+    else if (root == w) root = NULL;
+    n -= destroySubtree(w);
   }
 }
 
-// POSTCONDITION: The BST is empty (all nodes are properly removed/deleted)
+/*
+  # INPUT: a node w with no parent (or NULL), the root of a subtree detached from the BST
+  # OUTPUT: the number of nodes in the subtree
+  # POSTCONDITION: all the nodes of the subtree are destroyed, in postorder; the size of the BST is unchanged
+*/
+int
+BSTMap::destroySubtree(BSTMap::Node* w)
+{
+  int m = 0;
+  eulerTour(w, [this, &m](BSTMap::Node* x, TourStep step, int) {
+    if (step == TOUR_POST) {
+      destroyNode(x);
+      m++;
+    }
+  });
+  return m;
+}
+
+/*
+  # POSTCONDITION: The BST is empty (all nodes are properly removed/deleted)
+  # NOTE: unless the node pool is shared with another map, it is released in bulk without visiting the
+  # nodes, so node classes must not own resources beyond their own storage (node destructors are not run)
+*/
 void
 BSTMap::deleteAll()
 {
-  BSTMap::Node* w = root;
-  while (w) {
-    if (!(w->left || w->right)) {
-      BSTMap::Node* x = w;
-      w = w->parent;
-      if (w) {
-	if (w->left == x) w->left = NULL;
-	else w->right = NULL;
-      }
-      delete x;
-      n--;
-      continue;
-    }
-    w = (w->left) ? w->left : w->right;
+  if (pool.use_count() > 1) {
+    deleteNode(root);
+    return;
   }
+  root = NULL;
+  n = 0;
+  pool->release();
 }
 
-// Destructor
-// POSTCONDITION: The BST is empty
-BSTMap::~BSTMap() {
+// POSTCONDITION: the map is empty; its write-ahead log, if any, is checkpointed
+void
+BSTMap::clear()
+{
   deleteAll();
+  checkpointLog();
+}
+
+/*
+  # INPUT: another map, other, of the same class as this map
+  # POSTCONDITION: this map and other allocate their nodes from the same node pool, so nodes can be moved
+  # between them; the entries of both maps are unchanged
+  # NOTE: O(1), by adopting the whole pool of one map into the pool of the other, if at least one of them
+  # is empty or owns its pool alone; otherwise the entries of other are copied into new nodes in the pool
+  # of this map, in O(m) for m entries in other
+*/
+void
+BSTMap::sharePool(BSTMap& other) {
+  if (pool == other.pool) return;
+  if (!root) pool = other.pool;
+  else if (!other.root) other.pool = pool;
+  else if (other.pool.use_count() == 1) {
+    pool->adopt(*other.pool);
+    other.pool = pool;
+  }
+  else if (pool.use_count() == 1) {
+    other.pool->adopt(*pool);
+    pool = other.pool;
+  }
+  else {
+    vector<pair<int,int> > entries;
+    entries.reserve(other.size());
+    for (iterator i = other.begin(); i != other.end(); ++i)
+      entries.push_back(make_pair(i->key, i->value));
+    other.deleteAll();
+    other.pool = pool;
+    other.bulkLoad(entries, true);
+  }
 }
 
 /*
   # INPUT: a node w in the BST
   # OUTPUT: the parent of w, which may be NULL if w is the root of the BST
   # PRECONDITION: the left or right subtree, or both, of w are empty
-  # POSTCONDITION: the size of the BST is reduced by 1 after w is properly removed from the BST
+  # POSTCONDITION: w is unlinked from the BST (its child, if any, takes its place), but not destroyed: it is
+  # a single node with no parent or children, still allocated in the node pool; the size of the BST is
+  # reduced by 1
 */
 BSTMap::Node*
-BSTMap::removeNode(BSTMap::Node* w) {
+BSTMap::detachNode(BSTMap::Node* w) {
   BSTMap::Node* z = w->parent;
   // identify child if it exists
   BSTMap::Node* x = (w->left) ? w->left : w->right;
   makeChild(z, x, !z || (z->left == w));
   if (!z) root = x;
-  delete w;
+  w->left = w->right = w->parent = NULL;
   n--;
   return z;
 }
 
+/*
+  # INPUT: a node w in the BST, or NULL
+  # OUTPUT: the number of nodes in the subtree rooted at w
+  # NOTE: O(size of the subtree), by a traversal; subclasses that keep subtree sizes can do better
+*/
+int
+BSTMap::subtreeSize(const BSTMap::Node* w) const {
+  int m = 0;
+  eulerTour((BSTMap::Node*) w, [&m](BSTMap::Node*, TourStep step, int) {
+    if (step == TOUR_PRE) m++;
+  });
+  return m;
+}
+
+/*
+  # INPUT: a vector of map entries, as key-value pairs; a flag, sorted, true iff the keys in the vector are
+  # already strictly increasing
+  # POSTCONDITION: the map contains exactly the given entries (its previous entries are removed); if a key
+  # appears more than once, the last value given for it is kept, as if the entries were put in order;
+  # the BST is height-balanced (the sizes of the two subtrees of every node differ by at most 1); the
+  # write-ahead log of the map, if any, is checkpointed
+  # NOTE: O(n) if sorted, O(n log n) otherwise; nodes are created bottom-up, so each node is built from its
+  # already built children (see createNode) and no search or rebalancing is ever needed
+*/
+void
+BSTMap::bulkLoad(const vector<pair<int,int> >& entries, bool sorted) {
+  deleteAll();
+  if (sorted) {
+    root = buildTree(entries, 0, (int) entries.size());
+    checkpointLog();
+    return;
+  }
+  // sort by key, keeping the relative order of entries with the same key, and keep only the last one of those
+  vector<pair<int,int> > e(entries);
+  stable_sort(e.begin(), e.end(),
+	      [](const pair<int,int>& a, const pair<int,int>& b) { return a.first < b.first; });
+  size_t m = 0;
+  for (size_t i = 0; i < e.size(); i++) {
+    if (m > 0 && e[m-1].first == e[i].first) e[m-1] = e[i];
+    else e[m++] = e[i];
+  }
+  root = buildTree(e, 0, (int) m);
+  checkpointLog();
+}
+
+/*
+  # INPUT: a vector of map entries with strictly increasing keys; a range [lo, hi) of positions in it
+  # OUTPUT: the root of a new height-balanced subtree holding the entries in the range, or NULL if it is empty
+  # POSTCONDITION: the size of the BST is increased by hi - lo
+*/
+BSTMap::Node*
+BSTMap::buildTree(const vector<pair<int,int> >& entries, int lo, int hi) {
+  int i = lo;
+  auto next = [&entries, &i]() { return entries[i++]; };
+  return buildTree(hi - lo, next);
+}
+
+/*
+  # INPUT: a number of entries m; a function next() returning the next of them as a key-value pair, with
+  # strictly increasing keys
+  # OUTPUT: the root of a new height-balanced subtree holding the m entries returned by next, or NULL if m is 0
+  # POSTCONDITION: the size of the BST is increased by m
+  # NOTE: the entries are consumed in order (the left subtree of a node is built before its entry is taken),
+  # so they can be streamed from a file without being held in memory
+*/
+template <class Next>
+BSTMap::Node*
+BSTMap::buildTree(int m, Next& next) {
+  if (m <= 0) return NULL;
+  int half = m / 2;
+  BSTMap::Node* l = buildTree(half, next);
+  pair<int,int> e = next();
+  BSTMap::Node* r = buildTree(m - half - 1, next);
+  BSTMap::Node* w = createNode(e.first, e.second, l, r, NULL);
+  makeChild(w, l, true);
+  makeChild(w, r, false);
+  n++;
+  return w;
+}
+
+/*
+  # INPUT: the path of a file
+  # OUTPUT: true iff the snapshot was written successfully
+  # POSTCONDITION: the file holds a binary snapshot of the map (see the snapshot format above); it is written
+  # to a temporary file next to it first, synced, then renamed (and the rename synced), so an existing snapshot
+  # is replaced only by a complete one, which is on disk once saveSnapshot returns true
+  # NOTE: O(n), in one in-order traversal, streamed through a fixed-size buffer
+*/
+bool
+BSTMap::saveSnapshot(const string& path) const {
+  string tmp = path + ".tmp";
+  FILE* f = fopen(tmp.c_str(), "wb");
+  if (!f) return false;
+  vector<char> buf(SNAPSHOT_BUFFER_BYTES);
+  size_t len = SNAPSHOT_HEADER_BYTES;
+  bool ok = true;
+  memcpy(buf.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  putLE(buf.data() + sizeof(SNAPSHOT_MAGIC), n, 8);
+  SnapshotChecksum sum;
+  eulerTour(root, [&](BSTMap::Node* w, TourStep step, int) {
+    if (step != TOUR_IN) return;
+    if (len + SNAPSHOT_ENTRY_BYTES > buf.size()) {
+      ok = ok && fwrite(buf.data(), 1, len, f) == len;
+      len = 0;
+    }
+    putLE(buf.data() + len, (uint32_t) w->key, 4);
+    putLE(buf.data() + len + 4, (uint32_t) w->value, 4);
+    len += SNAPSHOT_ENTRY_BYTES;
+    sum.add(w->key, w->value);
+  });
+  if (len + SNAPSHOT_TRAILER_BYTES > buf.size()) {
+    ok = ok && fwrite(buf.data(), 1, len, f) == len;
+    len = 0;
+  }
+  putLE(buf.data() + len, sum.value(), 8);
+  len += SNAPSHOT_TRAILER_BYTES;
+  ok = ok && fwrite(buf.data(), 1, len, f) == len;
+  ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+  ok = (fclose(f) == 0) && ok;
+  if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+    remove(tmp.c_str());
+    return false;
+  }
+  return syncDirectory(path);
+}
+
+/*
+  # INPUT: the path of a file
+  # OUTPUT: true iff the file holds a valid snapshot (see the snapshot format above), which is then loaded
+  # POSTCONDITION: if loaded, the map contains exactly the entries of the snapshot (and its write-ahead log, if
+  # any, is checkpointed); otherwise it is unchanged
+  # NOTE: O(n), with no search or rebalancing: the entries are streamed from the file into buildTree, which
+  # creates the nodes bottom-up, each with its height (and stats) computed from its children (see createNode);
+  # the snapshot is rejected if its size does not match its header, if its keys are not strictly
+  # increasing, or if its checksum does not match
+*/
+bool
+BSTMap::loadSnapshot(const string& path) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  long fileBytes = (fseek(f, 0, SEEK_END) == 0) ? ftell(f) : -1;
+  rewind(f);
+  RecordReader in(f);
+  // check the header against the file size before building anything
+  const char* h = in.next(SNAPSHOT_HEADER_BYTES);
+  uint64_t m = h ? getLE(h + sizeof(SNAPSHOT_MAGIC), 8) : 0;
+  if (!h || memcmp(h, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || m > (uint64_t) INT_MAX ||
+      fileBytes != (long) (SNAPSHOT_HEADER_BYTES + m * SNAPSHOT_ENTRY_BYTES + SNAPSHOT_TRAILER_BYTES)) {
+    fclose(f);
+    return false;
+  }
+  // build the new tree next to the current one, which is kept in case the snapshot turns out to be corrupt
+  BSTMap::Node* oldRoot = root;
+  int oldN = n;
+  root = NULL;
+  n = 0;
+  bool ok = true;
+  int count = 0;
+  int lastKey = 0;
+  SnapshotChecksum sum;
+  auto next = [&]() {
+    const char* p = in.next(SNAPSHOT_ENTRY_BYTES);
+    if (!p) {
+      ok = false;
+      return make_pair(0, 0);
+    }
+    int k = (int) (uint32_t) getLE(p, 4);
+    int v = (int) (uint32_t) getLE(p + 4, 4);
+    if (count++ > 0 && k <= lastKey) ok = false;
+    lastKey = k;
+    sum.add(k, v);
+    return make_pair(k, v);
+  };
+  BSTMap::Node* r = buildTree((int) m, next);
+  const char* t = ok ? in.next(SNAPSHOT_TRAILER_BYTES) : NULL;
+  ok = t && getLE(t, 8) == sum.value();
+  fclose(f);
+  if (!ok) {
+    destroySubtree(r);
+    root = oldRoot;
+    n = oldN;
+    return false;
+  }
+  destroySubtree(oldRoot);
+  root = r;
+  checkpointLog();
+  return true;
+}
+
+// Destructor
+// POSTCONDITION: The BST is empty
+BSTMap::~BSTMap() {
+  deleteAll();
+}
+
+/*
+  # INPUT: a node w in the BST
+  # OUTPUT: the parent of w, which may be NULL if w is the root of the BST
+  # PRECONDITION: the left or right subtree, or both, of w are empty
+  # POSTCONDITION: the size of the BST is reduced by 1 after w is properly removed from the BST
+*/
+BSTMap::Node*
+BSTMap::removeNode(BSTMap::Node* w) {
+  BSTMap::Node* z = detachNode(w);
+  destroyNode(w);
+  return z;
+}
+
 /*
   # INPUT: a key k, as an integer
   # OUTPUT: the last node visited while trying to find a node with key k in the BST
@@ -357,10 +1211,11 @@ BSTMap::putNode(int k, int v) {
 
 /*
   # INPUT: a key-value pair k and v (both integers)
-  # POSTCONDITION: same as putNode member function 
+  # POSTCONDITION: same as putNode member function; the update is recorded to the write-ahead log first, if any
 */
 void
 BSTMap::put(int k, int v) {
+  if (wal) wal->append(WriteAheadLog::PUT, k, v);
   this->putNode(k,v);
 }
 
@@ -391,10 +1246,12 @@ BSTMap::eraseNode(int k) {
 /*
   # INPUT: a key k (as an integer)
   # OUTPUT: see output of eraseNode member function
-  # POSTCONDITION: see postcondition of eraseNode member function
+  # POSTCONDITION: see postcondition of eraseNode member function; the update is recorded to the write-ahead
+  # log first, if any
 */
 void
 BSTMap::erase(int k) {
+  if (wal) wal->append(WriteAheadLog::ERASE, k, 0);
   eraseNode(k);
 }
 
@@ -417,7 +1274,8 @@ BSTMap::youngestAncestorType(BSTMap::Node* w, bool check_left) const {
   if (!w) return NULL;
   BSTMap::Node* z = w;
   BSTMap::Node* x = z->parent;
-  while ((x && ((check_left ? x->left : x->right) == z))) {
+  // go up while z is a right/left child: its ancestors up to there have smaller/larger keys than w
+  while ((x && ((check_left ? x->right : x->left) == z))) {
     z = x;
     x = x->parent;
   }
@@ -472,6 +1330,43 @@ BSTMap::predecessor(BSTMap::Node* w) const {
   else return youngestAncestorType(w,false);
 }
 
+/*
+  # INPUT: a key k, as an integer
+  # OUTPUT: an iterator to the node with the smallest key not less than k, or end() if there is none
+  # NOTE: findNode stops at the node with key k or, if there is none, at either its would-be predecessor or
+  # successor, so at most one step to the successor is needed
+*/
+BSTMap::iterator
+BSTMap::lower_bound(int k) const {
+  BSTMap::Node* w = findNode(k);
+  if (w && (w->key < k)) w = successor(w);
+  return iterator(this, w);
+}
+
+/*
+  # INPUT: a key k, as an integer
+  # OUTPUT: an iterator to the node with the smallest key greater than k, or end() if there is none
+*/
+BSTMap::iterator
+BSTMap::upper_bound(int k) const {
+  BSTMap::Node* w = findNode(k);
+  if (w && (w->key <= k)) w = successor(w);
+  return iterator(this, w);
+}
+
+/*
+  # INPUT: a key k, as an integer
+  # OUTPUT: the pair of iterators lower_bound(k), upper_bound(k); the range between them holds the node with
+  # key k if in the map, and is empty otherwise
+*/
+pair<BSTMap::iterator,BSTMap::iterator>
+BSTMap::equal_range(int k) const {
+  BSTMap::Node* w = findNode(k);
+  if (w && (w->key == k)) return make_pair(iterator(this, w), iterator(this, successor(w)));
+  if (w && (w->key < k)) w = successor(w);
+  return make_pair(iterator(this, w), iterator(this, w));
+}
+
 // OUTPUT: size of the tree
 int
 BSTMap::size() const {
@@ -493,7 +1388,11 @@ class AVLTreeMap : public BSTMap {
 
 public:
   AVLTreeMap() { };  // default constructor
-  virtual ~AVLTreeMap() { }; // (overloadable) default destructor
+  // bulk-load constructor (see BSTMap::bulkLoad)
+  AVLTreeMap(const vector<pair<int,int> >& entries, bool sorted = false) { bulkLoad(entries, sorted); };
+  // (overloadable) default destructor (the nodes are destroyed here, while their class is still known; the
+  // write-ahead log is detached first, since destroying the map is not an update to checkpoint)
+  virtual ~AVLTreeMap() { wal = NULL; clear(); };
 
   // AVL Tree Node class (extends BSTMap's embedded Node class)
   class Node : public BSTMap::Node {
@@ -510,28 +1409,54 @@ public:
     // (overloadable) node destructor
     virtual ~Node() { };
 
-    // overloading output stream for a representation of AVL Tree node w
-    friend ostream& operator<<(ostream& os, const Node& w) {
-      os << ((BSTMap::Node) w) << "(" << w.ht << ")";
+    // overloading output sink operator for a representation of AVL Tree node w
+    friend OutputSink& operator<<(OutputSink& os, const Node& w) {
+      os << ((const BSTMap::Node&) w) << '(' << w.ht << ')';
       return os;
     };
   };
 
+  // split and join
+  bool split(int k, AVLTreeMap& right);
+  bool join(AVLTreeMap& right);
+  // range erase
+  int eraseRange(int lo, int hi);
+  // batched updates: put(key, value), or erase(key) if erase is true
+  struct Op {
+    int key;
+    int value;
+    bool erase;
+  };
+  void applyBatch(const vector<Op>& ops, bool sorted = false);
+  // a batch of fewer than 1/SPARSE_BATCH updates per entry of the map is applied one update at a time
+  static const int SPARSE_BATCH = 16;
+  // maximum number of entries in a range that eraseRange erases key by key
+  static const int SMALL_RANGE = 16;
+
   
 protected:
 
-  // (overloadable) auxiliary node creation utility
-  virtual Node* createNode(int k, int v, BSTMap::Node* l, BSTMap::Node* r, BSTMap::Node* p) { return new Node(k,v,(Node*) l,(Node*) r, (Node*) p); };
+  // (overloadable) auxiliary node creation/destruction utilities
+  virtual Node* createNode(int k, int v, BSTMap::Node* l, BSTMap::Node* r, BSTMap::Node* p) { return new (pool->allocate(sizeof(Node))) Node(k,v,(Node*) l,(Node*) r, (Node*) p); };
+  virtual void destroyNode(BSTMap::Node* w) { ((Node*) w)->~Node(); pool->deallocate(w, sizeof(Node)); };
 
   // prints a representation of AVL node w
   // (overloadable)
   // INPUT: node w
-  virtual void printNode(const BSTMap::Node* w) const { if (w) cout << *((Node*) w); };
+  virtual void printNode(const BSTMap::Node* w) const { if (w) *out << *((Node*) w); };
 
   // (overloadable) auxiliary utilities
   virtual void singleRotation(Node* y, Node* z);
   virtual Node* putNode(int k, int v);
   virtual Node* eraseNode(int k);
+  // (overloadable) recompute the per-node data of w from its children (here only its height)
+  virtual void resetNode(Node* w) { resetHeight(w); };
+  // (overloadable) true iff every ancestor of a changed node must be reset, even after heights stop changing
+  virtual bool updatesWholePath() const { return false; };
+  // subtree surgery utilities (on subtrees with no parent, detached from the tree)
+  Node* joinAux(Node* l, Node* m, Node* r);
+  Node* join2Aux(Node* l, Node* r);
+  void splitAux(Node* t, int k, Node*& l, Node*& found, Node*& r);
   
 private:
 
@@ -543,6 +1468,7 @@ private:
   Node* rebalance(Node* w);
   void doubleRotation(Node* x, Node* y, Node* z);  
   void rebalanceAncestors(Node* w);
+  Node* batchAux(Node* t, const Op* first, const Op* last, vector<pair<int,int> >& puts, int& delta, bool& changed);
   
 };
 
@@ -600,7 +1526,8 @@ AVLTreeMap::singleRotation(AVLTreeMap::Node* y, AVLTreeMap::Node* z) {
     makeChild(z->parent, y, z->parent->left == z);
   } else {
     y->parent = nullptr;
-    this->root = y;
+    // (a detached subtree has no parent either, but is not the tree)
+    if (this->root == z) this->root = y;
   }
 
   bool rotateLeft = y == z->right;
@@ -609,8 +1536,8 @@ AVLTreeMap::singleRotation(AVLTreeMap::Node* y, AVLTreeMap::Node* z) {
   makeChild(z, t, !rotateLeft); // set y's child to be the child of z
   makeChild(y, z, rotateLeft); // make z the child of y
   
-  resetHeight(z);
-  resetHeight(y);
+  resetNode(z);
+  resetNode(y);
 }
 
 /*
@@ -627,23 +1554,23 @@ AVLTreeMap::doubleRotation(AVLTreeMap::Node* x, AVLTreeMap::Node* y, AVLTreeMap:
 /*
   # INPUT: a node w
   # POSTCONDITION: a proper AVL Tree
+  # NOTE: a single upward pass that resets (see resetNode) and, if necessary, rebalances each node from w;
+  # it stops once the height of a subtree is unchanged, unless updatesWholePath() requires going up to the root
 */
 void
 AVLTreeMap::rebalanceAncestors(AVLTreeMap::Node* w) {
   // check ancestors and rebalance if necessary
   AVLTreeMap::Node* x;
   int old_height;
+  bool wholePath = updatesWholePath();
   while (w) {
     x = (AVLTreeMap::Node*) w->parent;
     old_height = height(w);
     if (balanced(w))
-      resetHeight(w);
-    else {
-      w = rebalance(w);
-      if (!x) 
-	      root = w;
-    }
-    w = (old_height == height(w)) ? NULL : x;
+      resetNode(w);
+    else
+      w = rebalance(w);  // (the root of the tree, if rotated away, is replaced in singleRotation)
+    w = (old_height == height(w) && !wholePath) ? NULL : x;
   }
 }
 
@@ -654,9 +1581,11 @@ AVLTreeMap::rebalanceAncestors(AVLTreeMap::Node* w) {
 */
 AVLTreeMap::Node*
 AVLTreeMap::putNode(int k, int v) {
+  int old_size = size();
   // first put like in a BST
   AVLTreeMap::Node* z = (AVLTreeMap::Node*) BSTMap::putNode(k,v);
-  if (z) rebalanceAncestors((Node*) z->parent);
+  // a new leaf is already set, so start at its parent; an updated node may need to be reset itself
+  if (z) rebalanceAncestors((size() == old_size) ? z : (Node*) z->parent);
   return z;
 }
 
@@ -667,12 +1596,301 @@ AVLTreeMap::putNode(int k, int v) {
 */
 AVLTreeMap::Node*
 AVLTreeMap::eraseNode(int k) {
+  int old_size = size();
   // first erase like in a BST
   AVLTreeMap::Node* z = (AVLTreeMap::Node*) BSTMap::eraseNode(k);
-  rebalanceAncestors(z);
+  // nothing to rebalance if the key was not in the map
+  if (size() != old_size) rebalanceAncestors(z);
   return z;
 }
 
+/*
+  # INPUT: the roots l and r of two AVL subtrees (or NULL), and a node m, with every key in l smaller than
+  # the key of m and every key in r larger; none of them has a parent, and m has no children
+  # OUTPUT: the root of a single AVL subtree holding the nodes of l, m and r, with no parent
+  # NOTE: O(|height(l) - height(r)| + 1): m is hung, with the shorter subtree as one of its children, on
+  # the inner spine of the taller subtree, at the first node at most 1 taller than the shorter subtree;
+  # then the nodes above it are rebalanced and reset as after a put
+  # NOTE: like splitAux and join2Aux, it only touches the nodes given (not the root of the map), so it can
+  # work on disjoint subtrees in parallel
+*/
+AVLTreeMap::Node*
+AVLTreeMap::joinAux(AVLTreeMap::Node* l, AVLTreeMap::Node* m, AVLTreeMap::Node* r) {
+  bool leftTaller = height(l) >= height(r);
+  AVLTreeMap::Node* t = leftTaller ? l : r;
+  AVLTreeMap::Node* s = leftTaller ? r : l;
+  AVLTreeMap::Node* p = NULL;
+  AVLTreeMap::Node* c = t;
+  while (height(c) > height(s) + 1) {
+    p = c;
+    c = (AVLTreeMap::Node*) (leftTaller ? c->right : c->left);
+  }
+  makeChild(m, leftTaller ? c : s, true);
+  makeChild(m, leftTaller ? s : c, false);
+  resetNode(m);
+  if (!p) return m;
+  makeChild(p, m, !leftTaller);
+  rebalanceAncestors(p);
+  // the root of the result is at the top of the path up from m
+  while (m->parent) m = (AVLTreeMap::Node*) m->parent;
+  return m;
+}
+
+/*
+  # INPUT: the roots l and r of two AVL subtrees (or NULL), with every key in l smaller than every key in r;
+  # neither of them has a parent
+  # OUTPUT: the root of a single AVL subtree holding the nodes of l and r, with no parent
+  # NOTE: O(log n): the largest node of l is taken out of it, by joining (see joinAux) the subtrees hanging
+  # off its right spine bottom-up, and then used to join the two subtrees
+*/
+AVLTreeMap::Node*
+AVLTreeMap::join2Aux(AVLTreeMap::Node* l, AVLTreeMap::Node* r) {
+  if (!l) return r;
+  if (!r) return l;
+  AVLTreeMap::Node* m = (AVLTreeMap::Node*) youngestDescendantType(l, false);
+  AVLTreeMap::Node* rest = (AVLTreeMap::Node*) m->left;
+  AVLTreeMap::Node* w = (AVLTreeMap::Node*) m->parent;
+  if (rest) rest->parent = NULL;
+  m->left = m->parent = NULL;
+  while (w) {
+    AVLTreeMap::Node* z = (AVLTreeMap::Node*) w->parent;
+    AVLTreeMap::Node* sub = (AVLTreeMap::Node*) w->left;
+    if (sub) sub->parent = NULL;
+    w->left = w->right = w->parent = NULL;
+    rest = joinAux(sub, w, rest);
+    w = z;
+  }
+  return joinAux(rest, m, r);
+}
+
+/*
+  # INPUT: the root t of an AVL subtree with no parent (or NULL); a key k (as an integer)
+  # OUTPUT (by reference): the roots l and r of two AVL subtrees with no parent (or NULL), holding the nodes
+  # of t with keys smaller and larger than k, respectively; and the node of t with key k, found, as a
+  # single node with no parent or children, or NULL if there is none
+  # NOTE: O(log n): the search path for k is taken apart bottom-up, and each subtree hanging off it is
+  # joined (see joinAux) onto the side it belongs to; the costs of these joins add up to the height of t
+*/
+void
+AVLTreeMap::splitAux(AVLTreeMap::Node* t, int k, AVLTreeMap::Node*& l, AVLTreeMap::Node*& found, AVLTreeMap::Node*& r) {
+  l = r = found = NULL;
+  // find the node with key k, or else the last node on the search path for it
+  AVLTreeMap::Node* w = t;
+  AVLTreeMap::Node* z = NULL;
+  while (w && (w->key != k)) {
+    z = w;
+    w = (AVLTreeMap::Node*) ((k < w->key) ? w->left : w->right);
+  }
+  if (w) {
+    found = w;
+    z = (AVLTreeMap::Node*) w->parent;
+    l = (AVLTreeMap::Node*) w->left;
+    r = (AVLTreeMap::Node*) w->right;
+    if (l) l->parent = NULL;
+    if (r) r->parent = NULL;
+    w->left = w->right = w->parent = NULL;
+  }
+  // go up the rest of the path; its part below each node w is already split into l and r
+  for (w = z; w; w = z) {
+    z = (AVLTreeMap::Node*) w->parent;
+    bool toRight = (k < w->key);
+    AVLTreeMap::Node* sub = (AVLTreeMap::Node*) (toRight ? w->right : w->left);
+    if (sub) sub->parent = NULL;
+    w->left = w->right = w->parent = NULL;
+    if (toRight) r = joinAux(r, w, sub);
+    else l = joinAux(sub, w, l);
+  }
+}
+
+/*
+  # INPUT: a key k (as an integer); another map, right, of the same class as this map
+  # OUTPUT: true, unless right is this map or of another class (then both maps are left unchanged)
+  # POSTCONDITION: the entries of this map with keys not smaller than k are moved to right, whose previous
+  # entries are removed; the entries with keys smaller than k stay in this map; both are proper AVL trees; the
+  # write-ahead logs of both maps, if any, are checkpointed
+  # NOTE: O(log n) (see splitAux), plus the cost of counting the entries moved (see subtreeSize), which is
+  # O(log n) only if subtree sizes are kept; the nodes are relinked, not copied, so right shares the node
+  # pool of this map afterwards
+*/
+bool
+AVLTreeMap::split(int k, AVLTreeMap& right) {
+  if ((&right == this) || (typeid(right) != typeid(*this))) return false;
+  right.clear();
+  right.sharePool(*this);
+  int total = size();
+  AVLTreeMap::Node* t = (AVLTreeMap::Node*) root;
+  setTree(NULL, 0);
+  AVLTreeMap::Node *l, *found, *r;
+  splitAux(t, k, l, found, r);
+  // the node with key k, if any, is the smallest one of right
+  if (found) r = joinAux(NULL, found, r);
+  int moved = subtreeSize(r);
+  setTree(l, total - moved);
+  right.setTree(r, moved);
+  checkpointLog();
+  right.checkpointLog();
+  return true;
+}
+
+/*
+  # INPUT: another map, right, of the same class as this map
+  # OUTPUT: true, unless right is this map or of another class, or some key of right is not larger than
+  # every key of this map (then both maps are left unchanged)
+  # POSTCONDITION: all the entries of right are moved to this map, which is a proper AVL tree; right is empty;
+  # the write-ahead logs of both maps, if any, are checkpointed
+  # NOTE: O(log n) (see join2Aux, and see sharePool for when the node pools of the maps cannot just be merged)
+*/
+bool
+AVLTreeMap::join(AVLTreeMap& right) {
+  if ((&right == this) || (typeid(right) != typeid(*this))) return false;
+  if (right.empty()) return true;
+  if (!empty() && (youngestDescendantType(root, false)->key >= youngestDescendantType(right.root, true)->key))
+    return false;
+  sharePool(right);
+  int total = size() + right.size();
+  AVLTreeMap::Node* l = (AVLTreeMap::Node*) root;
+  AVLTreeMap::Node* r = (AVLTreeMap::Node*) right.root;
+  right.setTree(NULL, 0);
+  setTree(join2Aux(l, r), total);
+  checkpointLog();
+  right.checkpointLog();
+  return true;
+}
+
+/*
+  # INPUT: keys lo and hi (as integers), not necessarily in the map
+  # OUTPUT: the number of entries erased
+  # POSTCONDITION: no node in the AVL tree has a key in [lo, hi]; the other entries are intact; the update is
+  # recorded to the write-ahead log first, if any
+  # NOTE: O(log n + k) for k entries erased: the tree is split at lo and at hi (see splitAux), the nodes
+  # in between are destroyed in a single pass, and the two outer parts are joined back (see join2Aux); so
+  # the tree is rebalanced, and the stats reset, along O(log n) nodes only once, not once per key
+  # NOTE: a range of at most SMALL_RANGE entries (found by walking successors) is cheaper to erase key by key
+*/
+int
+AVLTreeMap::eraseRange(int lo, int hi) {
+  if ((lo > hi) || empty()) return 0;
+  if (wal) wal->append(WriteAheadLog::ERASE_RANGE, lo, hi);
+  // collect the keys in the range, up to one more than a small range holds
+  int keys[SMALL_RANGE + 1];
+  int k = 0;
+  for (iterator i = lower_bound(lo); (i != end()) && (i->key <= hi) && (k <= SMALL_RANGE); ++i)
+    keys[k++] = i->key;
+  if (k <= SMALL_RANGE) {
+    for (int j = 0; j < k; j++) eraseNode(keys[j]);
+    return k;
+  }
+  int total = size();
+  AVLTreeMap::Node* t = (AVLTreeMap::Node*) root;
+  setTree(NULL, 0);
+  AVLTreeMap::Node *l, *mid, *r, *found;
+  splitAux(t, lo, l, found, mid);
+  int erased = destroySubtree(found);
+  splitAux(mid, hi, mid, found, r);
+  erased += destroySubtree(found) + destroySubtree(mid);
+  setTree(join2Aux(l, r), total - erased);
+  return erased;
+}
+
+/*
+  # INPUT: a vector of map updates, ops; a flag, sorted, true iff the keys in ops are already strictly increasing
+  # POSTCONDITION: the map is as if the updates were applied in order, by put and erase; so only the last
+  # update of each key counts; the updates are recorded to the write-ahead log first (in order), if any
+  # NOTE: O(m log(n/m + 1)) for m updates (plus O(m log m) to sort them, unless sorted): the updates are
+  # merged into the tree in a single pass (see batchAux), so the search paths they share are walked, and
+  # their nodes rebalanced and reset, only once for the whole batch
+  # NOTE: the updates of a sparse batch (see SPARSE_BATCH) share little more than the top of their search
+  # paths, which stays cached anyway when they are applied in order of keys; so they are just applied one
+  # at a time (in order of keys), which avoids the overhead of the recursive merge
+*/
+void
+AVLTreeMap::applyBatch(const vector<AVLTreeMap::Op>& ops, bool sorted) {
+  if (ops.empty()) return;
+  if (wal)
+    for (size_t i = 0; i < ops.size(); i++)
+      wal->append(ops[i].erase ? WriteAheadLog::ERASE : WriteAheadLog::PUT, ops[i].key, ops[i].value);
+  const vector<AVLTreeMap::Op>* b = &ops;
+  vector<AVLTreeMap::Op> e;
+  if (!sorted)
+    sorted = (adjacent_find(ops.begin(), ops.end(), [](const AVLTreeMap::Op& x, const AVLTreeMap::Op& y) {
+      return x.key >= y.key;
+    }) == ops.end());
+  if (!sorted) {
+    // sort by key, keeping the relative order of updates of the same key, and keep only the last one of those
+    e = ops;
+    stable_sort(e.begin(), e.end(),
+		[](const AVLTreeMap::Op& x, const AVLTreeMap::Op& y) { return x.key < y.key; });
+    size_t m = 0;
+    for (size_t i = 0; i < e.size(); i++) {
+      if (m > 0 && e[m-1].key == e[i].key) e[m-1] = e[i];
+      else e[m++] = e[i];
+    }
+    e.resize(m);
+    b = &e;
+  }
+  if ((long long) b->size() * SPARSE_BATCH < size()) {
+    for (size_t i = 0; i < b->size(); i++) {
+      const AVLTreeMap::Op& o = (*b)[i];
+      if (o.erase) eraseNode(o.key);
+      else putNode(o.key, o.value);
+    }
+    return;
+  }
+  int total = size();
+  AVLTreeMap::Node* t = (AVLTreeMap::Node*) root;
+  setTree(NULL, 0);
+  vector<pair<int,int> > puts;
+  int delta = 0;
+  bool changed;
+  t = batchAux(t, b->data(), b->data() + b->size(), puts, delta, changed);
+  setTree(t, total + delta);
+}
+
+/*
+  # INPUT: the root t of an AVL subtree (or NULL); a range [first, last) of updates with strictly increasing
+  # keys; a scratch vector, puts; a count of entries added (or, if negative, removed), delta
+  # OUTPUT: the root of the AVL subtree resulting from applying the updates to t; and, by reference, whether
+  # the subtree changed: if not, the output is t itself, untouched; otherwise it has no parent
+  # POSTCONDITION: the nodes of erased entries are destroyed; delta is updated
+  # NOTE: the updates are split around the key of t, those smaller and larger are merged into its left and
+  # right subtrees, and the results are joined, with or without t (see joinAux and join2Aux); updates that
+  # reach an empty subtree build a new one (see buildTree); a subtree where no update changes anything (such
+  # as erasing absent keys) is not touched at all, not even its root
+*/
+AVLTreeMap::Node*
+AVLTreeMap::batchAux(AVLTreeMap::Node* t, const AVLTreeMap::Op* first, const AVLTreeMap::Op* last,
+		     vector<pair<int,int> >& puts, int& delta, bool& changed) {
+  changed = false;
+  if (first == last) return t;
+  if (!t) {
+    puts.clear();
+    for (const AVLTreeMap::Op* o = first; o != last; o++)
+      if (!o->erase) puts.push_back(make_pair(o->key, o->value));
+    delta += (int) puts.size();
+    changed = !puts.empty();
+    return (AVLTreeMap::Node*) buildTree(puts, 0, (int) puts.size());
+  }
+  const AVLTreeMap::Op* mid = std::lower_bound(first, last, t->key,
+					       [](const AVLTreeMap::Op& o, int k) { return o.key < k; });
+  bool hit = (mid != last) && (mid->key == t->key);
+  bool lChanged, rChanged;
+  AVLTreeMap::Node* l = batchAux((AVLTreeMap::Node*) t->left, first, mid, puts, delta, lChanged);
+  AVLTreeMap::Node* r = batchAux((AVLTreeMap::Node*) t->right, hit ? mid + 1 : mid, last, puts, delta, rChanged);
+  changed = hit || lChanged || rChanged;
+  if (!changed) return t;
+  // detach t and its (possibly new) subtrees, and join them back
+  if (l) l->parent = NULL;
+  if (r) r->parent = NULL;
+  t->left = t->right = t->parent = NULL;
+  if (hit && mid->erase) {
+    destroyNode(t);
+    delta--;
+    return join2Aux(l, r);
+  }
+  if (hit) t->value = mid->value;
+  return joinAux(l, t, r);
+}
+
 /*
   # INPUT: a node w in the AVL tree
   # OUTPUT: the height of w in the AVL tree
@@ -701,6 +1919,62 @@ bool AVLTreeMap::balanced(AVLTreeMap::Node* w) {
   return (abs(height((AVLTreeMap::Node*) w->left) - height((AVLTreeMap::Node*) w->right)) <= 1);
 }
 
+/*
+  # INPUT: a map (with this log attached, or no log)
+  # OUTPUT: true iff the snapshot of the map was saved (to the snapshot path given to open) and the log emptied
+  # POSTCONDITION: the snapshot is on disk before the log is emptied, so the two together always hold every
+  # committed update; the pending records are dropped, since their updates are in the snapshot; if the
+  # snapshot cannot be saved, the log is kept but no longer describes the map (good() is false)
+*/
+bool
+WriteAheadLog::checkpoint(const BSTMap& map) {
+  if (fd < 0) return false;
+  if (!map.saveSnapshot(snapshot)) failed = true;
+  else {
+    pending = 0;
+    if (ftruncate(fd, 0) != 0 || fdatasync(fd) != 0) failed = true;
+  }
+  return !failed;
+}
+
+/*
+  # INPUT: a map, the path of its latest snapshot, and the path of its log
+  # OUTPUT: false iff the snapshot exists but is not valid, or the log could not be cut at its last valid record
+  # POSTCONDITION: the map holds the entries of the snapshot (none if there is no snapshot file) updated by the
+  # records of the log, up to the first incomplete or invalid one; the log file is cut after its last valid
+  # record, so the records appended to it later follow on from it; a log attached to the map is not written to
+  # during the replay, and it is checkpointed afterwards (see BSTMap::setLog)
+  # NOTE: O(s + r log n) for s entries in the snapshot and r records in the log
+*/
+bool
+WriteAheadLog::recover(AVLTreeMap& map, const string& snapshotPath, const string& logPath) {
+  WriteAheadLog* attached = map.getLog();
+  map.setLog(NULL);
+  bool ok = true;
+  if (access(snapshotPath.c_str(), F_OK) == 0) ok = map.loadSnapshot(snapshotPath);
+  else map.clear();
+  FILE* f = ok ? fopen(logPath.c_str(), "rb") : NULL;
+  if (f) {
+    RecordReader in(f);
+    off_t valid = 0;
+    const char* p;
+    while ((p = in.next(RECORD_BYTES)) && (getLE(p + 12, 4) == check(p))) {
+      uint32_t type = (uint32_t) getLE(p, 4);
+      int k = (int) (uint32_t) getLE(p + 4, 4);
+      int v = (int) (uint32_t) getLE(p + 8, 4);
+      if (type == PUT) map.put(k, v);
+      else if (type == ERASE) map.erase(k);
+      else if (type == ERASE_RANGE) map.eraseRange(k, v);
+      else break;
+      valid += RECORD_BYTES;
+    }
+    fclose(f);
+    ok = (truncate(logPath.c_str(), valid) == 0);
+  }
+  map.setLog(attached);
+  return ok;
+}
+
 /*
  Purpose: Class definition of TreeMapStats, an extension of AVLTreeMap to account for basic statistics about the (ordered) map associated with each node/subtree
  */
@@ -710,46 +1984,50 @@ public:
   // embedded node class extension of an AVL-Tree node
   class Node : public AVLTreeMap::Node {
   
-  private:
+  public:
     // stats class to account for basic statistics/information of subtree rooted at each node
+    // (or, more generally, of any set of map entries)
     class Stats {
       
     private:
       // data members: number of nodes/map entries stored in the subtree; sum of all the map values of map entries stored in the subtree; the minimum map value of all the map entries stored in the subtree; the maximum map value of the map entries stored in the subtree
+      // NOTE: the sum is a 64-bit integer; since there are at most INT_MAX entries, each with an int value, its
+      // magnitude stays below 2^62, so it cannot overflow
       int num;
-      int sum;
+      long long sum;
       int min;
       int max;
 
     public:
-      // stats constructors
-      Stats() { };
-      Stats(int v, Node *l, Node* r) : num(1), sum(v), min(v), max(v) {};
+      // stats constructors (the default one corresponds to an empty set of map entries)
+      Stats() : num(0), sum(0), min(0), max(0) { };
+      // (stats of the subtree rooted at a node with value v and children l and r, whose stats are already set)
+      Stats(int v, Node *l, Node* r) { updateStats(v, l ? &l->info : NULL, r ? &r->info : NULL); };
       // stats destructor
       ~Stats() { };
 
-      // overloading output stream for a representation of stats s
-      friend ostream& operator<<(ostream& os, const Stats& s) {
-	      os << "{" << s.num << "," << s.sum << "," << s.min << "," << s.max << "}";
+      // overloading output sink operator for a representation of stats s
+      friend OutputSink& operator<<(OutputSink& os, const Stats& s) {
+	      os << '{' << s.num << ',' << s.sum << ',' << s.min << ',' << s.max << '}';
 	      return os;
       };
 
       //Getters function
       int getNum() const {return num;}
-      int getSum() const {return sum;}
+      long long getSum() const {return sum;}
       int getMin() const {return min;}
       int getMax() const {return max;}
 
       //Setters function
       void setNum(int n){num = n;}
-      void setSum(int s){sum = s;}
+      void setSum(long long s){sum = s;}
       void setMin(int m){min = m;}
       void setMax(int m){max = m;}
 
       //To Update the stats of a node
       void updateStats(int value, const Stats* left, const Stats* right) {
         int newNum = 1 + (left ? left->getNum() : 0) + (right ? right->getNum() : 0);
-        int newSum = value + (left ? left->getSum() : 0) + (right ? right->getSum() : 0);
+        long long newSum = value + (left ? left->getSum() : 0) + (right ? right->getSum() : 0);
         int newMin = std::min(value, std::min(left ? left->getMin() : value, right ? right->getMin() : value));
         int newMax = std::max(value, std::max(left ? left->getMax() : value, right ? right->getMax() : value));
 
@@ -759,29 +2037,46 @@ public:
         setMax(newMax);
 
       }
+
+      //To merge the stats of another set of map entries, disjoint from this one, into these stats
+      void merge(const Stats& s) {
+        if (!s.num) return;
+        if (!num) {
+          *this = s;
+          return;
+        }
+        num += s.num;
+        sum += s.sum;
+        min = std::min(min, s.min);
+        max = std::max(max, s.max);
+      }
     };
 
-    // data member: node info/stats    
-    Stats *info;
+  private:
+    // data member: node info/stats (stored inline, so a node is a single allocation)
+    Stats info;
     
   public:
     // tree node constructors
     Node() : AVLTreeMap::Node() { };
-    Node(int k, int v, Node* l, Node* r, Node* p) : AVLTreeMap::Node(k,v,l,r,p)  {
-      info = new Stats(v, l, r);
-    };
+    Node(int k, int v, Node* l, Node* r, Node* p) : AVLTreeMap::Node(k,v,l,r,p), info(v, l, r) { };
 
     // tree node destructor
-    virtual ~Node() { if (this->info) delete this->info; };
+    virtual ~Node() { };
 
-    // overloading output stream for a representation of TreeMapStats node w
-    friend ostream& operator<<(ostream& os, const Node& w) {      
-      os << ((AVLTreeMap::Node) w) << *(w.info) ; 
+    // overloading output sink operator for a representation of TreeMapStats node w
+    friend OutputSink& operator<<(OutputSink& os, const Node& w) {      
+      os << ((const AVLTreeMap::Node&) w) << w.info ; 
       return os;
     };
 
     // (overloading) print utility for a node, including map entry and additional info and stats
-    void printStats() { cout << *this << endl; }
+    void printStats(OutputSink& os) { os << *this << '\n'; }
+
+    // OUTPUT: number of map entries stored in the subtree rooted at the node
+    int getNum() const { return info.getNum(); }
+    // OUTPUT: the stats of the subtree rooted at the node
+    const Stats& getInfo() const { return info; }
 
     /*
       # PRECONDITION: the info values for the left and right nodes for the children of the node have been properly set, consistent with the subtree that they root
@@ -790,11 +2085,7 @@ public:
 
    // function to update the stats of the node
    void updateInfo(Node* left, Node* right, int value) {
-        if (!info) {
-            info = new Stats(value, left, right);
-        }
-
-        info->updateStats(value, left ? left->info : NULL, right ? right->info : NULL);
+        info.updateStats(value, left ? &left->info : NULL, right ? &right->info : NULL);
     }
   };
 
@@ -803,25 +2094,69 @@ public:
   void printTreeMapStats(Node* w);
   void printTreeMap(); 
   // tree constructor
-  TreeMapStats() { };
-  // tree desctructor
-  virtual ~TreeMapStats() {  };
+  TreeMapStats() : visits(0) { };
+  // bulk-load constructor (see BSTMap::bulkLoad)
+  TreeMapStats(const vector<pair<int,int> >& entries, bool sorted = false) : visits(0) { bulkLoad(entries, sorted); };
+  // tree desctructor (the nodes are destroyed here, while their class is still known; see ~AVLTreeMap)
+  virtual ~TreeMapStats() { wal = NULL; clear(); };
   void updateTree(TreeMapStats::Node* w);
   void updateTreeTopDown(TreeMapStats::Node* w);
+  // OUTPUT: number of nodes reset (height and stats) by the last put or erase, or by the last split, join,
+  // eraseRange, applyBatch or set operation as a whole; but a range or batch small enough to be applied one key
+  // at a time (see SMALL_RANGE and SPARSE_BATCH) counts as its last put or erase
+  int nodeVisits() const { return visits; };
+  // order statistics
+  Node* select(int i) const;
+  int rank(int k) const;
+  Node* median() const;
+  // range aggregate query
+  Node::Stats rangeStats(int lo, int hi) const;
+  // read-only image of the map, to be queried in place (see MappedTreeMapStats)
+  bool saveImage(const string& path) const;
+  // split and join (see AVLTreeMap); O(log n), since subtree sizes are kept in the stats
+  bool split(int k, TreeMapStats& right) { visits = 0; return AVLTreeMap::split(k, right); };
+  bool join(TreeMapStats& right) { visits = 0; return AVLTreeMap::join(right); };
+  // range erase (see AVLTreeMap)
+  int eraseRange(int lo, int hi) { visits = 0; return AVLTreeMap::eraseRange(lo, hi); };
+  // batched updates (see AVLTreeMap)
+  void applyBatch(const vector<Op>& ops, bool sorted = false) { visits = 0; AVLTreeMap::applyBatch(ops, sorted); };
+  // set operations with another map, other, whose entries are moved into this map or freed, leaving it
+  // empty; the work is split among up to the given number of threads (0 for one per hardware thread)
+  void unionWith(TreeMapStats& other, int threads = 0);
+  void intersectWith(TreeMapStats& other, int threads = 0);
+  void difference(TreeMapStats& other, int threads = 0);
 
 protected:
-  // (overloadable) auxiliary node creation utility
-  virtual Node* createNode(int k, int v, BSTMap::Node* l, BSTMap::Node* r, BSTMap::Node* p) { return new Node(k,v,(Node*) l, (Node*) r, (Node*) p); };
+  // (overloadable) auxiliary node creation/destruction utilities
+  virtual Node* createNode(int k, int v, BSTMap::Node* l, BSTMap::Node* r, BSTMap::Node* p) { return new (pool->allocate(sizeof(Node))) Node(k,v,(Node*) l, (Node*) r, (Node*) p); };
+  virtual void destroyNode(BSTMap::Node* w) { ((Node*) w)->~Node(); pool->deallocate(w, sizeof(Node)); };
   
   // prints a representation of AVL node w
   // (overloadable)
   // INPUT: node w
-  virtual void printNode(const BSTMap::Node* w) const { if (w) cout << *((Node*) w); };
+  virtual void printNode(const BSTMap::Node* w) const { if (w) *out << *((Node*) w); };
 
   // (overloadable) auxiliary utilities
-  virtual void singleRotation(AVLTreeMap::Node* y, AVLTreeMap::Node* z);
   virtual Node* putNode(int key, int value);
   virtual Node* eraseNode(int key);
+  virtual void resetNode(AVLTreeMap::Node* w);
+  virtual bool updatesWholePath() const { return true; };
+  virtual int subtreeSize(const BSTMap::Node* w) const { return num(w); };
+
+private:
+  // data member: number of nodes reset by the current/last put or erase
+  int visits;
+
+  // set operation utilities
+  enum SetOp { UNION, INTERSECTION, DIFFERENCE };
+  // minimum number of entries in a pair of subtrees for their set operation to be split between two threads
+  static const int PARALLEL_GRAIN = 1 << 15;
+  void setOp(SetOp op, TreeMapStats& other, int threads);
+  Node* setOpAux(SetOp op, Node* a, Node* b, int forks, vector<BSTMap::Node*>& garbage);
+
+  // auxiliary utilities
+  static int num(const BSTMap::Node* w) { return (w) ? ((const Node*) w)->getNum() : 0; };
+  static void addSubtree(Node::Stats& s, const BSTMap::Node* w) { if (w) s.merge(((const Node*) w)->getInfo()); };
 };
 
 void 
@@ -839,21 +2174,17 @@ TreeMapStats::updateTree(TreeMapStats::Node* w){
 }
 
 /*
-  # overload of singleRotation member function of an AVLTreeMap
-  # see input, precondition, and postcondition for overloaded function
-  # POSTCONDITION: the info/stats of nodes y and z have been properly set; also see postcondition for overloaded function
+  # overload of resetNode member function of an AVLTreeMap
+  # POSTCONDITION: the height and the info/stats of node w have been properly set; since AVLTreeMap resets
+  # every node it touches (including both nodes of a rotation) through this function, heights, balance and
+  # stats are all maintained in the same single upward pass
 */
 void
-TreeMapStats::singleRotation(AVLTreeMap::Node* y, AVLTreeMap::Node* z) {
-  AVLTreeMap::singleRotation(y, z);
-  TreeMapStats::Node* w = (TreeMapStats::Node*) y;
-  TreeMapStats::Node* x = (TreeMapStats::Node*) z;
-  // Your code here
-
-  x->updateInfo((TreeMapStats::Node*)x->left, (TreeMapStats::Node*)x->right, x->value); // update the z node
-  if(w)
-    updateTree(w); // update node y and its parents
-  
+TreeMapStats::resetNode(AVLTreeMap::Node* w) {
+  AVLTreeMap::resetNode(w);
+  TreeMapStats::Node* x = (TreeMapStats::Node*) w;
+  x->updateInfo((TreeMapStats::Node*) x->left, (TreeMapStats::Node*) x->right, x->value);
+  visits++;
 }
 
 /*
@@ -863,12 +2194,8 @@ TreeMapStats::singleRotation(AVLTreeMap::Node* y, AVLTreeMap::Node* z) {
 */
 TreeMapStats::Node*
 TreeMapStats::putNode(int key, int value) {
-  TreeMapStats::Node* w = (TreeMapStats::Node*) AVLTreeMap::putNode(key,value);
-  // Your code here
-  if(w)
-    updateTree(w);
-
-  return w;
+  visits = 0;
+  return (TreeMapStats::Node*) AVLTreeMap::putNode(key,value);
 }
 /*
   # overload of eraseNode member function of an AVLTreeMap
@@ -877,12 +2204,202 @@ TreeMapStats::putNode(int key, int value) {
 */
 TreeMapStats::Node*
 TreeMapStats::eraseNode(int key) {
-  TreeMapStats::Node* w = (TreeMapStats::Node*) AVLTreeMap::eraseNode(key);
-  // Your code here
-  if(w)
-    updateTree(w);
+  visits = 0;
+  return (TreeMapStats::Node*) AVLTreeMap::eraseNode(key);
+}
 
-  return w;
+/*
+  # INPUT: a rank i (as an integer)
+  # OUTPUT: the node with the i-th smallest key in the map, counting from 0 (i.e., the node whose key has
+  # exactly i smaller keys in the map); or NULL if i is not between 0 and size()-1
+  # NOTE: O(log n), using the subtree sizes kept in the node stats
+*/
+TreeMapStats::Node*
+TreeMapStats::select(int i) const {
+  if (i < 0 || i >= size()) return NULL;
+  BSTMap::Node* w = root;
+  while (w) {
+    int l = num(w->left);
+    if (i == l) break;
+    if (i < l) w = w->left;
+    else {
+      // skip the left subtree and w itself
+      i -= l + 1;
+      w = w->right;
+    }
+  }
+  return (TreeMapStats::Node*) w;
+}
+
+/*
+  # INPUT: a key k (as an integer), not necessarily in the map
+  # OUTPUT: the number of keys in the map smaller than k
+  # NOTE: O(log n), using the subtree sizes kept in the node stats
+*/
+int
+TreeMapStats::rank(int k) const {
+  int r = 0;
+  BSTMap::Node* w = root;
+  while (w) {
+    if (w->key < k) {
+      // w and its whole left subtree are smaller than k
+      r += num(w->left) + 1;
+      w = w->right;
+    }
+    else w = w->left;
+  }
+  return r;
+}
+
+// OUTPUT: the node with the median key of the map (the lower one if the size is even); or NULL if the map is empty
+TreeMapStats::Node*
+TreeMapStats::median() const {
+  return select((size() - 1) / 2);
+}
+
+// POSTCONDITION: this map holds the entries of both maps, with the values of other for keys in both
+void
+TreeMapStats::unionWith(TreeMapStats& other, int threads) {
+  setOp(UNION, other, threads);
+}
+
+// POSTCONDITION: this map holds only its entries whose keys are also in other (with the values of this map)
+void
+TreeMapStats::intersectWith(TreeMapStats& other, int threads) {
+  setOp(INTERSECTION, other, threads);
+}
+
+// POSTCONDITION: this map holds only its entries whose keys are not in other
+void
+TreeMapStats::difference(TreeMapStats& other, int threads) {
+  setOp(DIFFERENCE, other, threads);
+}
+
+/*
+  # INPUT: a set operation op; another map, other; a maximum number of threads (0 for one per hardware thread)
+  # POSTCONDITION: see unionWith, intersectWith and difference; other is empty; the nodes dropped from both
+  # maps are destroyed; the write-ahead logs of both maps, if any, are checkpointed
+  # NOTE: O(m log(n/m + 1)) work for maps of sizes m <= n (see setOpAux); the nodes of other are relinked
+  # into this map, so both maps share their node pool afterwards (see sharePool); the dropped nodes are
+  # only collected during the operation, and destroyed at the end, since the node pool is not thread-safe
+*/
+void
+TreeMapStats::setOp(TreeMapStats::SetOp op, TreeMapStats& other, int threads) {
+  visits = 0;
+  if (&other == this) {
+    if (op == DIFFERENCE) clear();
+    return;
+  }
+  sharePool(other);
+  TreeMapStats::Node* a = (TreeMapStats::Node*) root;
+  TreeMapStats::Node* b = (TreeMapStats::Node*) other.root;
+  setTree(NULL, 0);
+  other.setTree(NULL, 0);
+  if (threads <= 0) threads = max(1, (int) thread::hardware_concurrency());
+  // each fork doubles the number of threads
+  int forks = 0;
+  while ((1 << forks) < threads) forks++;
+  vector<BSTMap::Node*> garbage;
+  TreeMapStats::Node* t = setOpAux(op, a, b, forks, garbage);
+  setTree(t, num(t));
+  for (size_t i = 0; i < garbage.size(); i++)
+    destroySubtree(garbage[i]);
+  checkpointLog();
+  other.checkpointLog();
+}
+
+/*
+  # INPUT: a set operation op; the roots a and b of two AVL subtrees with no parent (or NULL); the number of
+  # times, forks, that the work may still be split between two threads; a vector of dropped subtrees, garbage
+  # OUTPUT: the root, with no parent, of an AVL subtree holding the result of op on the entries of a and b
+  # POSTCONDITION: the roots of the subtrees of a and b not in the result are added to garbage
+  # NOTE: the join-based algorithm: b is split around the root of a (see splitAux), op is applied to the
+  # left subtree of a and the left part of b, and independently to the right ones, and the two results are
+  # joined, with or without the root of a (see joinAux and join2Aux); the left half runs on a new thread,
+  # through a helper map of its own (so the two threads never share a map), if there are forks left and the
+  # subtrees are large enough
+*/
+TreeMapStats::Node*
+TreeMapStats::setOpAux(TreeMapStats::SetOp op, TreeMapStats::Node* a, TreeMapStats::Node* b, int forks,
+                       vector<BSTMap::Node*>& garbage) {
+  if (!a || !b) {
+    TreeMapStats::Node* keep = (op == UNION) ? (a ? a : b) : ((op == DIFFERENCE) ? a : NULL);
+    if (a && (a != keep)) garbage.push_back(a);
+    if (b && (b != keep)) garbage.push_back(b);
+    return keep;
+  }
+  bool parallel = (forks > 0) && (num(a) + num(b) >= PARALLEL_GRAIN);
+  TreeMapStats::Node* al = (TreeMapStats::Node*) a->left;
+  TreeMapStats::Node* ar = (TreeMapStats::Node*) a->right;
+  if (al) al->parent = NULL;
+  if (ar) ar->parent = NULL;
+  a->left = a->right = NULL;
+  AVLTreeMap::Node *bl, *found, *br;
+  splitAux(b, a->key, bl, found, br);
+  TreeMapStats::Node* l;
+  TreeMapStats::Node* r;
+  if (parallel) {
+    TreeMapStats helper;
+    vector<BSTMap::Node*> helperGarbage;
+    thread left([&]() { l = helper.setOpAux(op, al, (TreeMapStats::Node*) bl, forks - 1, helperGarbage); });
+    r = setOpAux(op, ar, (TreeMapStats::Node*) br, forks - 1, garbage);
+    left.join();
+    visits += helper.visits;
+    garbage.insert(garbage.end(), helperGarbage.begin(), helperGarbage.end());
+  }
+  else {
+    l = setOpAux(op, al, (TreeMapStats::Node*) bl, 0, garbage);
+    r = setOpAux(op, ar, (TreeMapStats::Node*) br, 0, garbage);
+  }
+  // the root of a is kept in a union, in an intersection iff its key is in b, and in a difference iff not
+  bool keep = (op == UNION) || ((op == INTERSECTION) == (found != NULL));
+  if (found) {
+    if (op == UNION) a->value = found->value;
+    garbage.push_back(found);
+  }
+  if (!keep) {
+    garbage.push_back(a);
+    return (TreeMapStats::Node*) join2Aux(l, r);
+  }
+  return (TreeMapStats::Node*) joinAux(l, a, r);
+}
+
+/*
+  # INPUT: keys lo and hi (as integers), not necessarily in the map
+  # OUTPUT: the stats (number of entries, and sum, min and max of the map values) of all the map entries
+  # with keys in [lo, hi]; all zero if there are none
+  # NOTE: O(log n): below the node where the search paths for lo and hi split, each node on the path to lo
+  # (resp. hi) that is in the range contributes its own entry and the stats of its right (resp. left)
+  # subtree as a whole, so no subtree fully inside the range is entered
+*/
+TreeMapStats::Node::Stats
+TreeMapStats::rangeStats(int lo, int hi) const {
+  Node::Stats s;
+  BSTMap::Node* w = root;
+  // find the split node: the first node on the search path with key in [lo, hi]
+  while (w && (w->key < lo || w->key > hi))
+    w = (w->key < lo) ? w->right : w->left;
+  if (!w) return s;
+  s.merge(Node::Stats(w->value, NULL, NULL));
+  // entries with keys >= lo in the left subtree of the split node
+  for (BSTMap::Node* x = w->left; x; ) {
+    if (x->key >= lo) {
+      s.merge(Node::Stats(x->value, NULL, NULL));
+      addSubtree(s, x->right);
+      x = x->left;
+    }
+    else x = x->right;
+  }
+  // entries with keys <= hi in the right subtree of the split node
+  for (BSTMap::Node* x = w->right; x; ) {
+    if (x->key <= hi) {
+      s.merge(Node::Stats(x->value, NULL, NULL));
+      addSubtree(s, x->left);
+      x = x->right;
+    }
+    else x = x->left;
+  }
+  return s;
 }
 
 /*
@@ -911,91 +2428,472 @@ TreeMapStats::printTreeMap() {
 */
 void
 TreeMapStats::printTreeMapStats(TreeMapStats::Node* w) {
-  if (w) w->printStats();
+  if (w) w->printStats(*out);
   else printTreeMapStats();
 }
 
-//  MAIN PROGRAM: DO NOT CHANGE ANYTHING BELOW
+/*
+# Purpose: Class definition of MappedTreeMapStats, a read-only TreeMapStats queried in place from a memory-mapped
+# image file (written by TreeMapStats::saveImage), with no deserialization: opening an image of any size is
+# O(1), and processes mapping the same image share a single copy of it in the page cache
+# NOTE: the image is a header followed by an array of fixed-size, pointer-free nodes: each node holds its map
+# entry, the stats of its subtree, and the positions of its children in the array as 32-bit indices (NIL if
+# none); the nodes are in preorder, so the root is node 0 and a left child immediately follows its parent
+# NOTE: the nodes are mapped as they are stored, so an image is only valid on machines with the same byte
+# order (checked when opening it); its contents beyond the header are trusted
+*/
+class MappedTreeMapStats
+{
+
+public:
+  // node of the image
+  struct Node {
+    int key;
+    int value;
+    uint32_t left;
+    uint32_t right;
+    int num;
+    int min;
+    int max;
+    int unused;
+    long long sum;
+  };
+  // image header
+  struct Header {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t nodeBytes;
+    uint64_t count;
+  };
+
+  static const uint32_t NIL = 0xffffffff;
+  static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+  static const char* magic() { return "MAPIMG01"; };
+
+  // map constructor (no image)
+  MappedTreeMapStats() : base(NULL), bytes(0), nodes(NULL), n(0) { };
+  // map destructor
+  ~MappedTreeMapStats() { close(); };
+
+  bool open(const string& path);
+  void close();
+  bool isOpen() const { return base != NULL; };
+
+  // basic map operations (the nodes returned are valid until the image is closed)
+  const Node* find(int k) const;
+  int size() const { return n; };
+  bool empty() const { return n == 0; };
+  // order statistics and range aggregate query (as in TreeMapStats)
+  const Node* select(int i) const;
+  int rank(int k) const;
+  TreeMapStats::Node::Stats rangeStats(int lo, int hi) const;
+  TreeMapStats::Node::Stats stats() const { return info(node(0)); };
+
+private:
+  MappedTreeMapStats(const MappedTreeMapStats&) = delete;
+  MappedTreeMapStats& operator=(const MappedTreeMapStats&) = delete;
+
+  // data members: mapped image and its size in bytes; node array and its size (number of map entries)
+  void* base;
+  size_t bytes;
+  const Node* nodes;
+  int n;
+
+  // OUTPUT: the node at position i of the array (NULL if i is NIL or out of range)
+  const Node* node(uint32_t i) const { return (i < (uint32_t) n) ? nodes + i : NULL; };
+  static int num(const Node* w) { return w ? w->num : 0; };
+  static TreeMapStats::Node::Stats info(const Node* w);
+};
+
+/*
+  # INPUT: the path of an image file
+  # OUTPUT: true iff the file holds a valid image, which is then mapped (replacing any image open before)
+  # NOTE: O(1): only the header is checked against the file size; pages of nodes are read in on first use
+*/
+bool
+MappedTreeMapStats::open(const string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(Header)) {
+    ::close(fd);
+    return false;
+  }
+  void* p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) return false;
+  const Header* h = (const Header*) p;
+  if (memcmp(h->magic, magic(), sizeof(h->magic)) != 0 || h->byteOrder != BYTE_ORDER_MARK ||
+      h->nodeBytes != sizeof(Node) || h->count > (uint64_t) INT_MAX ||
+      (size_t) st.st_size != sizeof(Header) + h->count * sizeof(Node)) {
+    munmap(p, st.st_size);
+    return false;
+  }
+  close();
+  base = p;
+  bytes = st.st_size;
+  nodes = (const Node*) ((const char*) p + sizeof(Header));
+  n = (int) h->count;
+  return true;
+}
+
+// POSTCONDITION: the image (if any) is unmapped; the map is empty
+void
+MappedTreeMapStats::close() {
+  if (base) munmap(base, bytes);
+  base = NULL;
+  bytes = 0;
+  nodes = NULL;
+  n = 0;
+}
+
+// OUTPUT: the stats of the subtree rooted at node w (all zero if w is NULL)
+TreeMapStats::Node::Stats
+MappedTreeMapStats::info(const Node* w) {
+  TreeMapStats::Node::Stats s;
+  if (w) {
+    s.setNum(w->num);
+    s.setSum(w->sum);
+    s.setMin(w->min);
+    s.setMax(w->max);
+  }
+  return s;
+}
+
+/*
+  # INPUT: a key k
+  # OUTPUT: the node with key k if in the map; otherwise returns NULL
+*/
+const MappedTreeMapStats::Node*
+MappedTreeMapStats::find(int k) const {
+  const Node* w = node(0);
+  while (w && w->key != k)
+    w = node((k < w->key) ? w->left : w->right);
+  return w;
+}
+
+/*
+  # INPUT: a position i (as an integer)
+  # OUTPUT: the node with the i-th smallest key (counting from 0), or NULL if i is out of range
+*/
+const MappedTreeMapStats::Node*
+MappedTreeMapStats::select(int i) const {
+  if (i < 0 || i >= n) return NULL;
+  const Node* w = node(0);
+  while (w) {
+    int l = num(node(w->left));
+    if (i == l) break;
+    if (i < l) w = node(w->left);
+    else {
+      i -= l + 1;
+      w = node(w->right);
+    }
+  }
+  return w;
+}
+
+/*
+  # INPUT: a key k (as an integer), not necessarily in the map
+  # OUTPUT: the number of keys in the map smaller than k
+*/
+int
+MappedTreeMapStats::rank(int k) const {
+  int r = 0;
+  const Node* w = node(0);
+  while (w) {
+    if (w->key < k) {
+      r += num(node(w->left)) + 1;
+      w = node(w->right);
+    }
+    else w = node(w->left);
+  }
+  return r;
+}
+
+/*
+  # INPUT: keys lo and hi (as integers), not necessarily in the map
+  # OUTPUT: the stats of all the map entries with keys in [lo, hi]; all zero if there are none
+  # NOTE: O(log n), as TreeMapStats::rangeStats
+*/
+TreeMapStats::Node::Stats
+MappedTreeMapStats::rangeStats(int lo, int hi) const {
+  TreeMapStats::Node::Stats s;
+  const Node* w = node(0);
+  // find the split node: the first node on the search path with key in [lo, hi]
+  while (w && (w->key < lo || w->key > hi))
+    w = node((w->key < lo) ? w->right : w->left);
+  if (!w) return s;
+  s.merge(TreeMapStats::Node::Stats(w->value, NULL, NULL));
+  // entries with keys >= lo in the left subtree of the split node
+  for (const Node* x = node(w->left); x; ) {
+    if (x->key >= lo) {
+      s.merge(TreeMapStats::Node::Stats(x->value, NULL, NULL));
+      s.merge(info(node(x->right)));
+      x = node(x->left);
+    }
+    else x = node(x->right);
+  }
+  // entries with keys <= hi in the right subtree of the split node
+  for (const Node* x = node(w->right); x; ) {
+    if (x->key <= hi) {
+      s.merge(TreeMapStats::Node::Stats(x->value, NULL, NULL));
+      s.merge(info(node(x->left)));
+      x = node(x->right);
+    }
+    else x = node(x->left);
+  }
+  return s;
+}
+
+/*
+  # INPUT: the path of a file
+  # OUTPUT: true iff the image was written successfully
+  # POSTCONDITION: the file holds a read-only image of the map (see MappedTreeMapStats), with the same tree
+  # shape and stats; as saveSnapshot, it is written to a temporary file first, then renamed
+  # NOTE: O(n), in one preorder traversal: the left child of the node at position i is at i + 1, and its
+  # right child at i + 1 + (size of its left subtree), known from the stats
+*/
+bool
+TreeMapStats::saveImage(const string& path) const {
+  typedef MappedTreeMapStats::Node ImageNode;
+  string tmp = path + ".tmp";
+  FILE* f = fopen(tmp.c_str(), "wb");
+  if (!f) return false;
+  MappedTreeMapStats::Header h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, MappedTreeMapStats::magic(), sizeof(h.magic));
+  h.byteOrder = MappedTreeMapStats::BYTE_ORDER_MARK;
+  h.nodeBytes = sizeof(ImageNode);
+  h.count = size();
+  bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+  vector<ImageNode> buf;
+  buf.reserve(SNAPSHOT_BUFFER_BYTES / sizeof(ImageNode));
+  uint32_t next = 0;
+  eulerTour(root, [&](BSTMap::Node* w, TourStep step, int) {
+    if (step != TOUR_PRE) return;
+    const Node::Stats& s = ((const Node*) w)->getInfo();
+    ImageNode x;
+    memset(&x, 0, sizeof(x));
+    x.key = w->key;
+    x.value = w->value;
+    x.left = w->left ? next + 1 : MappedTreeMapStats::NIL;
+    x.right = w->right ? next + 1 + num(w->left) : MappedTreeMapStats::NIL;
+    x.num = s.getNum();
+    x.sum = s.getSum();
+    x.min = s.getMin();
+    x.max = s.getMax();
+    next++;
+    buf.push_back(x);
+    if (buf.size() == buf.capacity()) {
+      ok = ok && fwrite(buf.data(), sizeof(ImageNode), buf.size(), f) == buf.size();
+      buf.clear();
+    }
+  });
+  ok = ok && fwrite(buf.data(), sizeof(ImageNode), buf.size(), f) == buf.size();
+  ok = (fclose(f) == 0) && ok;
+  if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+    remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+// the driver program is left out when this file is included by the tests (see tests/)
+#ifndef TREE_MAP_STATS_NO_MAIN
+
+//  MAIN PROGRAM: the output of the commands must stay byte for byte as it is (see tests/ParserTest.cpp)
 
 int main() {
 
   string inputFilename = "input.txt";
-  string line;
+  string_view line;
   bool echo = true;
 
+  // write-ahead log of the updates of the map, once opened by the wal command (committed on exit)
+  WriteAheadLog wal;
   TreeMapStats L;
+  // all replies go to the output sink of the map, flushed at the end or by the flush command
+  OutputSink& out = L.output();
   // open input file
-  fstream inputFile;
-  loadFile(inputFilename, inputFile);
-  while (getline(inputFile, line)){
-    
-      // trim whitespace
+  CommandReader input(inputFilename);
+  while (input.nextLine(line)){
+
       // echo input
-      if (echo) cout << line << endl;
-      // parse input using a stringstream
-      stringstream lineSS(line);
-      string token;
-      string command = "";
-      // store tokens in a vector
-      vector<string> tokens;
-      while (getline(lineSS, token, ' ')){
-	    // trim whitespace
-	      token.erase(token.find_last_not_of(" \n\r\t") + 1);
-	      tokens.push_back(token);
-	    }
-
-      if (tokens.size() > 0){
-	      command = tokens[0]; // first token is the command
-	    }  
-      if (tokens.size() > 1){
-
-	      if (command == "erase")
-	        L.erase(stoi(tokens[1]));
-	      
-        if (command == "put")
-	        L.put(stoi(tokens[1]), stoi(tokens[2]));
-	        
-	      if (command == "find"){
-	        int k = stoi(tokens[1]);
-	        TreeMapStats::Node* w = (TreeMapStats::Node*) L.find(k);
-	        if (w)
-		        cout << w->value << endl;
-	        else
-		        cout << "Not found!" << endl;
-	      }
-
-	      if (command == "print_key_stats"){
-	          int k = stoi(tokens[1]);
-	          TreeMapStats::Node* w = (TreeMapStats::Node*) L.find(k);
-	          if (w)
-		          L.printTreeMapStats(w);
-	          else
-		          cout << "Not found!" << endl;  
-	      }
-
-	    }
-
-      if (command == "size")
-	      cout << L.size() << endl;
-	
-      if (command == "print")
-	      L.printMap();
-	
-      if (command == "print_stats")
-	      L.print();
-	
-      if (command == "print_tree")
+      if (echo) {
+        out << line << '\n';
+      }
+      // parse the command, then its integer arguments as needed
+      // (commands with missing or malformed arguments are ignored)
+      string_view args = line;
+      int k, v;
+      TreeMapStats::Node* w;
+
+      switch (parseCommand(nextToken(args))) {
+
+      case CMD_ERASE:
+        if (nextInt(args, k))
+          L.erase(k);
+        break;
+
+      case CMD_ERASE_RANGE:
+        if (nextInt(args, k) && nextInt(args, v))
+          L.eraseRange(k, v);
+        break;
+
+      case CMD_PUT:
+        if (nextInt(args, k) && nextInt(args, v))
+          L.put(k, v);
+        break;
+
+      case CMD_FIND:
+        if (nextInt(args, k)) {
+          w = (TreeMapStats::Node*) L.find(k);
+          if (w)
+            out << w->value << '\n';
+          else
+            out << "Not found!" << '\n';
+        }
+        break;
+
+      case CMD_SELECT:
+        if (nextInt(args, k)) {
+          w = L.select(k);
+          if (w)
+            out << *((BSTMap::Node*) w) << '\n';
+          else
+            out << "Not found!" << '\n';
+        }
+        break;
+
+      case CMD_RANK:
+        if (nextInt(args, k))
+          out << L.rank(k) << '\n';
+        break;
+
+      case CMD_SCAN:
+        // scan lo hi [limit]
+        if (nextInt(args, k) && nextInt(args, v)) {
+          int limit;
+          if (!nextInt(args, limit)) limit = -1;
+          L.printRange(k, v, limit);
+        }
+        break;
+
+      case CMD_RANGE_STATS:
+        if (nextInt(args, k) && nextInt(args, v))
+          out << L.rangeStats(k, v) << '\n';
+        break;
+
+      case CMD_PRINT_KEY_STATS:
+        if (nextInt(args, k)) {
+          w = (TreeMapStats::Node*) L.find(k);
+          if (w)
+            L.printTreeMapStats(w);
+          else
+            out << "Not found!" << '\n';
+        }
+        break;
+
+      case CMD_SIZE:
+        out << L.size() << '\n';
+        break;
+
+      case CMD_NODE_VISITS:
+        out << L.nodeVisits() << '\n';
+        break;
+
+      case CMD_MEDIAN:
+        w = L.median();
+        if (w)
+          out << *((BSTMap::Node*) w) << '\n';
+        else
+          out << "Not found!" << '\n';
+        break;
+
+      case CMD_PRINT:
+        L.printMap();
+        break;
+
+      case CMD_PRINT_STATS:
+        L.print();
+        break;
+
+      case CMD_PRINT_TREE:
         L.printTreeMap();
-      
-      if (command == "print_stats_tree")
+        break;
+
+      case CMD_PRINT_STATS_TREE:
         L.printTreeMapStats();
-        
-      if (command == "noecho")
+        break;
+
+      case CMD_NOECHO:
         echo = false;
-        
+        break;
+
+      case CMD_FLUSH:
+        out.flush();
+        if (wal.isOpen() && !wal.commit())
+          out << "Cannot commit log\n";
+        break;
+
+      case CMD_SAVE: {
+        string_view path = nextToken(args);
+        if (!path.empty() && !L.saveSnapshot(string(path)))
+          out << "Cannot save snapshot " << path << '\n';
+        break;
+      }
+
+      case CMD_LOAD: {
+        string_view path = nextToken(args);
+        if (!path.empty() && !L.loadSnapshot(string(path)))
+          out << "Cannot load snapshot " << path << '\n';
+        break;
+      }
+
+      case CMD_WAL: {
+        // wal log snapshot [records [millis]]: attaching the log checkpoints the map, so recover first, if
+        // needed; there is no commit timer, so the records pending a millis limit wait for the next update,
+        // flush, or the end of the input
+        string_view path = nextToken(args);
+        string_view snapshot = nextToken(args);
+        int records, millis;
+        if (snapshot.empty()) break;
+        if (!nextInt(args, records)) records = 1;
+        if (!nextInt(args, millis)) millis = 0;
+        L.setLog(NULL);
+        wal.setGroupCommit(records, millis);
+        if (!wal.open(string(path), string(snapshot)))
+          out << "Cannot open log " << path << '\n';
+        else {
+          L.setLog(&wal);
+          if (!wal.good())
+            out << "Cannot checkpoint to " << snapshot << '\n';
+        }
+        break;
+      }
+
+      case CMD_CHECKPOINT:
+        if (wal.isOpen() && !wal.checkpoint(L))
+          out << "Cannot checkpoint log\n";
+        break;
+
+      case CMD_RECOVER: {
+        // recover snapshot log
+        string_view snapshot = nextToken(args);
+        string_view log = nextToken(args);
+        if (!log.empty() && !WriteAheadLog::recover(L, string(snapshot), string(log)))
+          out << "Cannot recover from " << snapshot << " and " << log << '\n';
+        break;
+      }
+
+      case CMD_UNKNOWN:
+        break;
+      }
   }
 
+  out.flush();
   return EXIT_SUCCESS;
 
 }
 
+#endif // TREE_MAP_STATS_NO_MAIN
@@ -0,0 +1,158 @@
+/*
+# Purpose: Slab-based node allocator shared by the tree-based ordered map implementations
+*/
+
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+/*
+# Purpose: Class definition of NodePool, a simple slab allocator for the nodes of the tree-based maps
+# NOTE: requests are grouped into size classes (multiples of GRANULE bytes); each size class carves its
+# blocks out of large slabs and recycles freed blocks through an intrusive free list, so steady put/erase
+# churn never reaches malloc; all slabs are returned at once by release() (or when the pool is destroyed)
+# NOTE: requests larger than the largest size class fall back to plain operator new/delete
+# NOTE: a pool can take over all the slabs and free blocks of another pool in O(1) (see adopt), so maps
+# can merge their pools before moving subtrees between each other
+*/
+class NodePool
+{
+
+public:
+  // pool constructor
+  NodePool() : slabs(NULL), lastSlab(NULL) { memset(classes, 0, sizeof(classes)); };
+  // pool destructor
+  ~NodePool() { release(); };
+
+  void* allocate(size_t sz);
+  void deallocate(void* p, size_t sz);
+  void release();
+  void adopt(NodePool& other);
+
+private:
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+
+  // blocks of a size class whose size is a multiple of ALIGN are aligned to ALIGN, the others to GRANULE; since
+  // the size of a type is a multiple of its alignment, a block fits any object of the requested size either way
+  static const size_t ALIGN = 16;
+  static const size_t GRANULE = 8;
+  static const size_t NUM_CLASSES = 32;     // size classes of GRANULE, 2*GRANULE, ..., NUM_CLASSES*GRANULE bytes
+  static const size_t SLAB_BYTES = 1 << 16;
+
+  // free blocks are linked through their own storage; slabs are linked through their header
+  struct FreeBlock { FreeBlock* next; };
+  struct Slab { Slab* next; alignas(ALIGN) char data[1]; };
+  struct SizeClass {
+    FreeBlock* freeList; // recycled blocks
+    FreeBlock* freeTail; // last recycled block (meaningful only if freeList is not NULL)
+    char* cur;           // next never-used block in the current slab
+    char* end;           // end of the current slab
+  };
+
+  // data members: per size class bookkeeping; list of all slabs owned by the pool, and its last slab
+  SizeClass classes[NUM_CLASSES];
+  Slab* slabs;
+  Slab* lastSlab;
+};
+
+/*
+  # INPUT: a request size sz in bytes
+  # OUTPUT: a pointer to an uninitialized block of at least sz bytes, aligned for any object of sz bytes
+  # (to ALIGN, or to GRANULE if sz is not a multiple of ALIGN)
+*/
+inline void*
+NodePool::allocate(size_t sz) {
+  size_t c = (sz + GRANULE - 1) / GRANULE - 1;
+  if (sz == 0 || c >= NUM_CLASSES) return ::operator new(sz);
+  SizeClass& sc = classes[c];
+  // reuse a freed block if there is one
+  if (sc.freeList) {
+    FreeBlock* b = sc.freeList;
+    sc.freeList = b->next;
+    return b;
+  }
+  // otherwise carve a new block, starting a new slab if the current one is used up
+  size_t bsz = (c + 1) * GRANULE;
+  if ((size_t) (sc.end - sc.cur) < bsz) {
+    Slab* s = (Slab*) ::operator new(offsetof(Slab, data) + SLAB_BYTES);
+    s->next = slabs;
+    if (!slabs) lastSlab = s;
+    slabs = s;
+    sc.cur = s->data;
+    sc.end = s->data + SLAB_BYTES;
+  }
+  void* b = sc.cur;
+  sc.cur += bsz;
+  return b;
+}
+
+/*
+  # INPUT: a block p previously returned by allocate(sz), and the same request size sz
+  # POSTCONDITION: the block is available for reuse by a later request of the same size class
+*/
+inline void
+NodePool::deallocate(void* p, size_t sz) {
+  if (!p) return;
+  size_t c = (sz + GRANULE - 1) / GRANULE - 1;
+  if (sz == 0 || c >= NUM_CLASSES) {
+    ::operator delete(p);
+    return;
+  }
+  FreeBlock* b = (FreeBlock*) p;
+  if (!classes[c].freeList) classes[c].freeTail = b;
+  b->next = classes[c].freeList;
+  classes[c].freeList = b;
+}
+
+/*
+  # POSTCONDITION: every slab is returned to the system in one pass over the slab list (not over the blocks);
+  # all blocks previously handed out by the pool are invalid
+*/
+inline void
+NodePool::release() {
+  while (slabs) {
+    Slab* s = slabs;
+    slabs = s->next;
+    ::operator delete(s);
+  }
+  lastSlab = NULL;
+  memset(classes, 0, sizeof(classes));
+}
+
+/*
+  # INPUT: another pool, other
+  # POSTCONDITION: this pool owns all the slabs of other, so every block handed out by other is now a block
+  # of this pool (to be deallocated to it, and released with it); the free blocks of other are recycled by
+  # this pool; other is empty
+  # NOTE: O(1) (constant in the number of slabs and blocks); the unused part of the current slab of a size
+  # class of other is kept only if this pool has none left in that size class
+*/
+inline void
+NodePool::adopt(NodePool& other) {
+  if (&other == this || !other.slabs) return;
+  other.lastSlab->next = slabs;
+  if (!slabs) lastSlab = other.lastSlab;
+  slabs = other.slabs;
+  for (size_t c = 0; c < NUM_CLASSES; c++) {
+    SizeClass& sc = classes[c];
+    SizeClass& oc = other.classes[c];
+    if (oc.freeList) {
+      oc.freeTail->next = sc.freeList;
+      if (!sc.freeList) sc.freeTail = oc.freeTail;
+      sc.freeList = oc.freeList;
+    }
+    if ((size_t) (sc.end - sc.cur) < (c + 1) * GRANULE) {
+      sc.cur = oc.cur;
+      sc.end = oc.end;
+    }
+  }
+  other.slabs = NULL;
+  other.lastSlab = NULL;
+  memset(other.classes, 0, sizeof(other.classes));
+}
+
+#endif // NODE_POOL_H
@@ -0,0 +1,216 @@
+/*
+# Purpose: Header-only version of BasicTreeMapStats whose nodes have no parent link: put and erase record the
+# links followed on the way down on a small stack, and rebalance and reset the nodes on the path by popping it
+# NOTE: this saves the parent pointer per node, and the stores that keep it current on every link change and
+# rotation; the rebalancing is that of the path-copying layer (see PathCopyingTreeMapBase), applied in place
+*/
+
+#ifndef PATH_STACK_TREE_MAP_STATS_H
+#define PATH_STACK_TREE_MAP_STATS_H
+
+#include <ostream>
+#include <type_traits>
+
+#include "NodePool.h"
+#include "PersistentTreeMapStats.h"
+
+// node of a PathStackTreeMapStats: map entry, child links, height, and the aggregate of the subtree
+template <class K, class V, class Aggregate>
+class PathStackTreeMapStatsNode : public PathCopyingNodeBase<PathStackTreeMapStatsNode<K, V, Aggregate>, K, V, Aggregate> {
+public:
+  PathStackTreeMapStatsNode(const K& k, const V& v) : PathCopyingNodeBase<PathStackTreeMapStatsNode, K, V, Aggregate>(k, v) { };
+};
+
+/*
+# Purpose: Class definition of PathStackTreeMapStats, mapping keys of type K to values of type V using an AVL
+# tree whose nodes keep the Aggregate of their subtree (as BasicTreeMapStats), with no parent links
+# NOTE: the stack holds the addresses of the links followed from the root (the root pointer itself, then
+# child fields of the nodes on the path), so the node popped can be replaced in its parent after a rotation
+# without knowing the parent; it is a fixed array of MAX_HEIGHT entries, since no AVL tree of fewer than 2^64
+# nodes is taller (a tree of height h has at least F(h + 2) - 1 nodes, for the Fibonacci numbers F)
+# NOTE: every node is updated in place (the mut hook of the path-copying layer returns the node itself); the
+# updates make the same rebalancing decisions as BasicTreeMapStats, so both build the same trees
+*/
+template <class K, class V, class Aggregate = StatsAggregate<V>, class Compare = std::less<K> >
+class PathStackTreeMapStats :
+  public PathCopyingTreeMapBase<PathStackTreeMapStats<K, V, Aggregate, Compare>, PathStackTreeMapStatsNode<K, V, Aggregate>,
+                                K, V, Aggregate, Compare>
+{
+  typedef PathCopyingTreeMapBase<PathStackTreeMapStats, PathStackTreeMapStatsNode<K, V, Aggregate>, K, V, Aggregate, Compare> Base;
+  friend Base;
+
+public:
+  typedef PathStackTreeMapStatsNode<K, V, Aggregate> Node;
+  typedef typename Aggregate::type Info;
+
+  static const int MAX_HEIGHT = 92;
+
+  // map constructors
+  PathStackTreeMapStats() : root(NULL), n(0) { };
+  explicit PathStackTreeMapStats(const Compare& c) : Base(c), root(NULL), n(0) { };
+  // map destructor
+  ~PathStackTreeMapStats() { clear(); };
+
+  // basic map operations
+  const Node* find(const K& k) const { return this->findNode(root, k); };
+  void put(const K& k, const V& v);
+  bool erase(const K& k);
+  size_t size() const { return n; };
+  bool empty() const { return !root; };
+  void clear();
+  // OUTPUT: the aggregate of the map entries with keys in [lo, hi]
+  Info rangeStats(const K& lo, const K& hi) const { return this->rangeInfo(root, lo, hi); };
+  // OUTPUT: the aggregate of the whole map (the identity if the map is empty)
+  Info stats() const { return this->info(root); };
+  // print utility: parenthetic string of entries
+  void printMap(std::ostream& os) const { printAux(os, root); os << "\n"; };
+
+private:
+  PathStackTreeMapStats(const PathStackTreeMapStats&) = delete;
+  PathStackTreeMapStats& operator=(const PathStackTreeMapStats&) = delete;
+
+  // data members: tree root node; tree size; allocator for all the nodes of the tree
+  Node* root;
+  size_t n;
+  NodePool pool;
+
+  // hooks
+  Node* createNode(const K& k, const V& v) { return new (pool.allocate(sizeof(Node))) Node(k, v); };
+  Node* mut(Node* w) { return w; };
+  Node* removeNode(Node* w);
+
+  // auxiliary utilities
+  Node** descend(const K& k, Node** path[], int& d);
+  void updatePath(Node** path[], int d);
+  void destroyAll(Node* w);
+  static void printAux(std::ostream& os, const Node* w);
+};
+
+/*
+  # INPUT: a key k, and an empty stack of links, path (of MAX_HEIGHT entries), with d = 0
+  # OUTPUT: the link that holds (or would hold) the node with key k
+  # POSTCONDITION: path[0..d-1] are the links followed from the root to the returned one, the root pointer first
+*/
+template <class K, class V, class A, class C>
+inline typename PathStackTreeMapStats<K,V,A,C>::Node**
+PathStackTreeMapStats<K,V,A,C>::descend(const K& k, Node** path[], int& d) {
+  Node** link = &root;
+  while (*link) {
+    // as BSTMapBase::findNode: both comparisons unconditionally, so the descent is a conditional move
+    Node* w = *link;
+    bool goLeft = this->comp(k, w->key);
+    bool goRight = this->comp(w->key, k);
+    if (!(goLeft | goRight)) break;
+    path[d++] = link;
+    link = goLeft ? &w->left : &w->right;
+  }
+  return link;
+}
+
+/*
+  # INPUT: a stack of d links, path, from the root down
+  # POSTCONDITION: the nodes held by the links are rebalanced (if needed) and reset, from the deepest one up;
+  # each link then holds the new root of its subtree
+*/
+template <class K, class V, class A, class C>
+inline void
+PathStackTreeMapStats<K,V,A,C>::updatePath(Node** path[], int d) {
+  while (d > 0) {
+    Node** link = path[--d];
+    *link = this->balance(*link);
+  }
+}
+
+/*
+  # INPUT: a key-value pair k and v
+  # POSTCONDITION: the map maps k to v; the nodes on the path to the root are reset and rebalanced
+*/
+template <class K, class V, class A, class C>
+void
+PathStackTreeMapStats<K,V,A,C>::put(const K& k, const V& v) {
+  Node** path[MAX_HEIGHT];
+  int d = 0;
+  Node** link = descend(k, path, d);
+  if (*link) {
+    (*link)->value = v;
+    this->resetNode(*link);
+  } else {
+    *link = createNode(k, v);
+    n++;
+  }
+  updatePath(path, d);
+}
+
+/*
+  # INPUT: a node w with at most one child
+  # OUTPUT: that child (or NULL), which takes the place of w
+  # POSTCONDITION: the storage of w is returned to the node pool
+*/
+template <class K, class V, class A, class C>
+inline typename PathStackTreeMapStats<K,V,A,C>::Node*
+PathStackTreeMapStats<K,V,A,C>::removeNode(Node* w) {
+  Node* c = w->left ? w->left : w->right;
+  w->~Node();
+  pool.deallocate(w, sizeof(Node));
+  return c;
+}
+
+/*
+  # INPUT: a key k
+  # OUTPUT: true iff k was in the map
+  # POSTCONDITION: the map does not contain k; the nodes on the path to the root are reset and rebalanced
+*/
+template <class K, class V, class A, class C>
+bool
+PathStackTreeMapStats<K,V,A,C>::erase(const K& k) {
+  Node** path[MAX_HEIGHT];
+  int d = 0;
+  Node** link = descend(k, path, d);
+  Node* w = *link;
+  if (!w) return false;
+  if (w->left && w->right) {
+    // replace the entry by that of its successor, and remove the successor node instead
+    path[d++] = link;
+    link = &w->right;
+    while ((*link)->left) {
+      path[d++] = link;
+      link = &(*link)->left;
+    }
+    w->key = (*link)->key;
+    w->value = (*link)->value;
+  }
+  *link = removeNode(*link);
+  n--;
+  updatePath(path, d);
+  return true;
+}
+
+// POSTCONDITION: the subtree rooted at w has its node destructors run, in postorder (only needed for non-trivial nodes)
+template <class K, class V, class A, class C>
+void
+PathStackTreeMapStats<K,V,A,C>::destroyAll(Node* w) {
+  eulerTour(w, [](Node* x, TourStep step, int) { if (step == TOUR_POST) x->~Node(); });
+}
+
+// POSTCONDITION: the map is empty; the node pool is released in bulk
+template <class K, class V, class A, class C>
+void
+PathStackTreeMapStats<K,V,A,C>::clear() {
+  if (!std::is_trivially_destructible<Node>::value) destroyAll(root);
+  root = NULL;
+  n = 0;
+  pool.release();
+}
+
+// utility/aux function to print out a parenthetic string representation of the entries in the subtree rooted at w
+template <class K, class V, class A, class C>
+void
+PathStackTreeMapStats<K,V,A,C>::printAux(std::ostream& os, const Node* w) {
+  eulerTour(w, [&os](const Node* x, TourStep step, int) {
+    if (step == TOUR_PRE) os << "[" << x->key << ":" << x->value << "](";
+    else if (step == TOUR_IN) os << "),(";
+    else os << ")";
+  });
+}
+
+#endif // PATH_STACK_TREE_MAP_STATS_H
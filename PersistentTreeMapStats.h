@@ -0,0 +1,428 @@
+/*
+# Purpose: Header-only, persistent (path-copying) version of BasicTreeMapStats: copying a map is O(1) and yields
+# an independent point-in-time snapshot; updates copy only the nodes on their search path and share every
+# other subtree with the snapshots taken before them
+# NOTE: also provides the path-copying layer shared with ConcurrentTreeMapStats
+*/
+
+#ifndef PERSISTENT_TREE_MAP_STATS_H
+#define PERSISTENT_TREE_MAP_STATS_H
+
+#include <atomic>
+#include <ostream>
+
+#include "BasicTreeMapStats.h"
+
+// node of a path-copying map: map entry, links (no parent link, since subtrees are shared between versions
+// of the tree), height, and the aggregate of the subtree
+template <class N, class K, class V, class Aggregate>
+class PathCopyingNodeBase {
+public:
+  K key;
+  V value;
+  N* left;
+  N* right;
+  int ht;
+  typename Aggregate::type info;
+
+  // node constructors (a new leaf, or a copy of node w sharing its children)
+  PathCopyingNodeBase(const K& k, const V& v) :
+    key(k), value(v), left(NULL), right(NULL), ht(1), info(Aggregate::lift(v)) { };
+  PathCopyingNodeBase(const N& w) :
+    key(w.key), value(w.value), left(w.left), right(w.right), ht(w.ht), info(w.info) { };
+};
+
+/*
+# Purpose: Class definition of PathCopyingTreeMapBase, the path-copying AVL layer (with subtree aggregates)
+# of PersistentTreeMapStats and ConcurrentTreeMapStats
+# NOTE: the updates work top-down from a subtree root held by the caller and return the root of the new
+# version of the subtree; before changing a node they ask Derived for a mutable one (see mut hook), so nodes
+# that other versions of the tree can still reach are never modified
+# NOTE: hooks of Derived (with Derived as the most derived map class, as in BSTMapBase):
+#   createNode(k, v): a new, mutable leaf
+#   mut(w): w itself if the running update may modify it, or else a mutable copy of w taking its place; w is
+#     the root, or a child of a node returned by mut or createNode
+#   removeNode(w): unlink w (as mut, reached from the root through mutable nodes), which has at most one
+#     child; returns that child (or NULL), which takes its place
+# NOTE: rebalancing makes the same decisions as AVLTreeMap::rebalance
+*/
+template <class Derived, class Node, class K, class V, class Aggregate, class Compare>
+class PathCopyingTreeMapBase
+{
+
+public:
+  typedef typename Aggregate::type Info;
+
+protected:
+  PathCopyingTreeMapBase() { };
+  explicit PathCopyingTreeMapBase(const Compare& c) : comp(c) { };
+
+  // data member: key comparator
+  Compare comp;
+
+  Derived& derived() { return *static_cast<Derived*>(this); };
+
+  // queries on the subtree rooted at w
+  const Node* findNode(const Node* w, const K& k) const;
+  Info rangeInfo(const Node* w, const K& lo, const K& hi) const;
+
+  // updates of the subtree rooted at t (see the hooks)
+  Node* putAux(Node* t, const K& k, const V& v, bool& added);
+  Node* eraseAux(Node* t, const K& k);
+  Node* eraseMin(Node* t, Node* dst);
+
+  // auxiliary utilities
+  static int height(const Node* w) { return w ? w->ht : 0; };
+  static Info info(const Node* w) { return w ? w->info : Aggregate::identity(); };
+  static void resetNode(Node* w);
+  Node* rotate(Node* z, bool rotateLeft);
+  Node* balance(Node* t);
+};
+
+/*
+  # INPUT: the root w of a subtree (possibly NULL), and a key k
+  # OUTPUT: the node with key k in the subtree, or NULL if there is none
+*/
+template <class D, class N, class K, class V, class A, class C>
+const N*
+PathCopyingTreeMapBase<D,N,K,V,A,C>::findNode(const N* w, const K& k) const {
+  while (w) {
+    // as BSTMapBase::findNode: both comparisons unconditionally, so the descent is a conditional move
+    bool goLeft = comp(k, w->key);
+    bool goRight = comp(w->key, k);
+    if (!(goLeft | goRight)) break;
+    w = goLeft ? w->left : w->right;
+  }
+  return w;
+}
+
+/*
+  # INPUT: the root w of a subtree (possibly NULL), and keys lo and hi, not necessarily in the subtree
+  # OUTPUT: the aggregate of the entries of the subtree with keys in [lo, hi] (the identity if there are none)
+  # NOTE: O(log n), as TreeMapStats::rangeStats; the parts of the range are combined in key order
+*/
+template <class D, class N, class K, class V, class A, class C>
+typename A::type
+PathCopyingTreeMapBase<D,N,K,V,A,C>::rangeInfo(const N* w, const K& lo, const K& hi) const {
+  // find the split node: the first node on the search path with key in [lo, hi]
+  while (w && (comp(w->key, lo) || comp(hi, w->key)))
+    w = comp(w->key, lo) ? w->right : w->left;
+  if (!w) return A::identity();
+  Info l = A::identity();
+  Info r = A::identity();
+  // entries with keys >= lo in the left subtree of the split node, from the largest down
+  for (const N* x = w->left; x; ) {
+    if (!comp(x->key, lo)) {
+      l = A::combine(A::combine(A::lift(x->value), info(x->right)), l);
+      x = x->left;
+    }
+    else x = x->right;
+  }
+  // entries with keys <= hi in the right subtree of the split node, from the smallest up
+  for (const N* x = w->right; x; ) {
+    if (!comp(hi, x->key)) {
+      r = A::combine(r, A::combine(info(x->left), A::lift(x->value)));
+      x = x->right;
+    }
+    else x = x->left;
+  }
+  return A::combine(A::combine(l, A::lift(w->value)), r);
+}
+
+// POSTCONDITION: the height and aggregate of node w are recomputed from its children
+template <class D, class N, class K, class V, class A, class C>
+inline void
+PathCopyingTreeMapBase<D,N,K,V,A,C>::resetNode(N* w) {
+  w->ht = std::max(height(w->left), height(w->right)) + 1;
+  w->info = A::combine(A::combine(info(w->left), A::lift(w->value)), info(w->right));
+}
+
+/*
+  # INPUT: a mutable node z, and the direction of the rotation
+  # OUTPUT: the new root of the subtree rooted at z, after a single rotation at z (making the child of z
+  # that takes its place mutable); z and that child are reset
+*/
+template <class D, class N, class K, class V, class A, class C>
+N*
+PathCopyingTreeMapBase<D,N,K,V,A,C>::rotate(N* z, bool rotateLeft) {
+  N* y = derived().mut(rotateLeft ? z->right : z->left);
+  if (rotateLeft) {
+    z->right = y->left;
+    y->left = z;
+  } else {
+    z->left = y->right;
+    y->right = z;
+  }
+  resetNode(z);
+  resetNode(y);
+  return y;
+}
+
+/*
+  # INPUT: a mutable node t whose children are proper AVL subtrees differing in height by at most 2
+  # OUTPUT: the root of a proper AVL subtree with the entries of the subtree rooted at t, with nodes reset
+*/
+template <class D, class N, class K, class V, class A, class C>
+N*
+PathCopyingTreeMapBase<D,N,K,V,A,C>::balance(N* t) {
+  int d = height(t->left) - height(t->right);
+  if (d > 1) {
+    if (height(t->left->left) < height(t->left->right)) t->left = rotate(derived().mut(t->left), true);
+    return rotate(t, false);
+  }
+  if (d < -1) {
+    if (height(t->right->right) < height(t->right->left)) t->right = rotate(derived().mut(t->right), false);
+    return rotate(t, true);
+  }
+  resetNode(t);
+  return t;
+}
+
+/*
+  # INPUT: the root t of a subtree (possibly NULL), and a key-value pair k and v
+  # OUTPUT: the root of the new version of the subtree, with the entry put; added is set iff k is a new key
+*/
+template <class D, class N, class K, class V, class A, class C>
+N*
+PathCopyingTreeMapBase<D,N,K,V,A,C>::putAux(N* t, const K& k, const V& v, bool& added) {
+  if (!t) {
+    added = true;
+    return derived().createNode(k, v);
+  }
+  t = derived().mut(t);
+  if (comp(k, t->key)) t->left = putAux(t->left, k, v, added);
+  else if (comp(t->key, k)) t->right = putAux(t->right, k, v, added);
+  else t->value = v;
+  return balance(t);
+}
+
+/*
+  # INPUT: the root t of a non-empty subtree, and a mutable node dst outside of it
+  # OUTPUT: the root of the new version of the subtree without its minimum entry, which is moved to dst
+*/
+template <class D, class N, class K, class V, class A, class C>
+N*
+PathCopyingTreeMapBase<D,N,K,V,A,C>::eraseMin(N* t, N* dst) {
+  if (!t->left) {
+    dst->key = t->key;
+    dst->value = t->value;
+    return derived().removeNode(t);
+  }
+  t = derived().mut(t);
+  t->left = eraseMin(t->left, dst);
+  return balance(t);
+}
+
+/*
+  # INPUT: the root t of a subtree, and a key k
+  # OUTPUT: the root of the new version of the subtree without key k
+  # PRECONDITION: key k is in the subtree (so that nothing is copied in vain)
+*/
+template <class D, class N, class K, class V, class A, class C>
+N*
+PathCopyingTreeMapBase<D,N,K,V,A,C>::eraseAux(N* t, const K& k) {
+  bool goLeft = comp(k, t->key);
+  if (goLeft || comp(t->key, k)) {
+    t = derived().mut(t);
+    if (goLeft) t->left = eraseAux(t->left, k);
+    else t->right = eraseAux(t->right, k);
+    return balance(t);
+  }
+  if (!t->left || !t->right) return derived().removeNode(t);
+  // replace the entry by that of its successor, removed from the right subtree
+  t = derived().mut(t);
+  t->right = eraseMin(t->right, t);
+  return balance(t);
+}
+
+// node of a PersistentTreeMapStats: adds the number of references to the node (from maps and from other nodes)
+template <class K, class V, class Aggregate>
+class PersistentTreeMapStatsNode : public PathCopyingNodeBase<PersistentTreeMapStatsNode<K, V, Aggregate>, K, V, Aggregate> {
+  typedef PathCopyingNodeBase<PersistentTreeMapStatsNode, K, V, Aggregate> Base;
+
+public:
+  std::atomic<int> refs;
+
+  PersistentTreeMapStatsNode(const K& k, const V& v) : Base(k, v), refs(1) { };
+  PersistentTreeMapStatsNode(const PersistentTreeMapStatsNode& w) : Base(w), refs(1) { };
+};
+
+/*
+# Purpose: Class definition of PersistentTreeMapStats, mapping keys of type K to values of type V using an AVL
+# tree whose nodes keep the Aggregate of their subtree (as BasicTreeMapStats), with value semantics and O(1) copies
+# NOTE: a copy of a map (a snapshot) shares the whole tree with it; nodes are reference counted, and put or
+# erase copy a node on their path only if it is shared (with a snapshot, or with another version of the map),
+# updating a map that shares no nodes in place, without any copying; a node is freed when its last reference
+# is dropped, so each version keeps exactly the nodes it can reach
+# NOTE: a map object must be used by one thread at a time, but maps sharing nodes may be used (queried,
+# updated, copied or destroyed) by different threads at the same time: e.g., an ingest thread may hand
+# snapshot() to a reporting thread, which reads a consistent point-in-time view while ingest continues
+# NOTE: nodes are allocated with operator new, not from a NodePool, since the last reference to a node may
+# be dropped by any thread
+*/
+template <class K, class V, class Aggregate = StatsAggregate<V>, class Compare = std::less<K> >
+class PersistentTreeMapStats :
+  public PathCopyingTreeMapBase<PersistentTreeMapStats<K, V, Aggregate, Compare>, PersistentTreeMapStatsNode<K, V, Aggregate>,
+                                K, V, Aggregate, Compare>
+{
+  typedef PathCopyingTreeMapBase<PersistentTreeMapStats, PersistentTreeMapStatsNode<K, V, Aggregate>, K, V, Aggregate, Compare> Base;
+  friend Base;
+
+public:
+  typedef PersistentTreeMapStatsNode<K, V, Aggregate> Node;
+  typedef typename Aggregate::type Info;
+
+  // map constructors (a copy is an O(1) snapshot)
+  PersistentTreeMapStats() : root(NULL), n(0) { };
+  explicit PersistentTreeMapStats(const Compare& c) : Base(c), root(NULL), n(0) { };
+  PersistentTreeMapStats(const PersistentTreeMapStats& m) : Base(m.comp), root(retain(m.root)), n(m.n) { };
+  PersistentTreeMapStats(PersistentTreeMapStats&& m) : Base(m.comp), root(m.root), n(m.n) { m.root = NULL; m.n = 0; };
+  PersistentTreeMapStats& operator=(const PersistentTreeMapStats& m);
+  PersistentTreeMapStats& operator=(PersistentTreeMapStats&& m);
+  // map destructor
+  ~PersistentTreeMapStats() { release(root); };
+
+  // OUTPUT: a point-in-time snapshot of the map, unaffected by later updates of the map (and vice versa)
+  PersistentTreeMapStats snapshot() const { return *this; };
+
+  // basic map operations
+  const Node* find(const K& k) const { return this->findNode(root, k); };
+  void put(const K& k, const V& v);
+  bool erase(const K& k);
+  size_t size() const { return n; };
+  bool empty() const { return !root; };
+  void clear() { release(root); root = NULL; n = 0; };
+  // OUTPUT: the aggregate of the map entries with keys in [lo, hi]
+  Info rangeStats(const K& lo, const K& hi) const { return this->rangeInfo(root, lo, hi); };
+  // OUTPUT: the aggregate of the whole map (the identity if the map is empty)
+  Info stats() const { return this->info(root); };
+  // print utility: parenthetic string of entries
+  void printMap(std::ostream& os) const { printAux(os, root); os << "\n"; };
+
+private:
+  // data members: tree root node (one reference to it); tree size
+  Node* root;
+  size_t n;
+
+  // reference counting utilities
+  static Node* retain(Node* w) { if (w) w->refs.fetch_add(1, std::memory_order_relaxed); return w; };
+  static void release(Node* w);
+
+  // hooks
+  Node* createNode(const K& k, const V& v) { return new Node(k, v); };
+  Node* mut(Node* w);
+  Node* removeNode(Node* w);
+
+  static void printAux(std::ostream& os, const Node* w);
+};
+
+/*
+  # INPUT: a node w, or NULL
+  # POSTCONDITION: one reference to w is dropped; if it was the last one, w is freed and its references to
+  # its children are dropped in turn
+  # NOTE: the nodes to be freed are visited by an Euler tour (see eulerTour) that only descends into a child
+  # when the reference to it dropped by its parent was the last one, so shared subtrees are not visited
+*/
+template <class K, class V, class A, class C>
+void
+PersistentTreeMapStats<K,V,A,C>::release(Node* w) {
+  if (!w || w->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+  if (!w->left && !w->right) {
+    delete w;
+    return;
+  }
+  auto drop = [](Node* c) -> Node* { return (c && c->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) ? c : NULL; };
+  eulerTour(w, (Node*) NULL, [&drop](Node* x) { return drop(x->left); }, [&drop](Node* x) { return drop(x->right); },
+            [](Node* x, TourStep step, int) { if (step == TOUR_POST) delete x; });
+}
+
+/*
+  # INPUT: a node w, reached from the root through nodes referenced only once
+  # OUTPUT: w if it is referenced only once (so no other version of the map can reach it); otherwise a copy
+  # of w, holding references to its children, which takes its place (and its reference to w is dropped)
+*/
+template <class K, class V, class A, class C>
+inline typename PersistentTreeMapStats<K,V,A,C>::Node*
+PersistentTreeMapStats<K,V,A,C>::mut(Node* w) {
+  if (w->refs.load(std::memory_order_acquire) == 1) return w;
+  Node* x = new Node(*w);
+  retain(x->left);
+  retain(x->right);
+  release(w);
+  return x;
+}
+
+/*
+  # INPUT: a node w (as mut) with at most one child
+  # OUTPUT: that child (or NULL), which takes the place of w (and the reference to w is dropped)
+*/
+template <class K, class V, class A, class C>
+inline typename PersistentTreeMapStats<K,V,A,C>::Node*
+PersistentTreeMapStats<K,V,A,C>::removeNode(Node* w) {
+  Node* c = retain(w->left ? w->left : w->right);
+  release(w);
+  return c;
+}
+
+template <class K, class V, class A, class C>
+PersistentTreeMapStats<K,V,A,C>&
+PersistentTreeMapStats<K,V,A,C>::operator=(const PersistentTreeMapStats& m) {
+  Node* r = retain(m.root);
+  release(root);
+  root = r;
+  n = m.n;
+  this->comp = m.comp;
+  return *this;
+}
+
+template <class K, class V, class A, class C>
+PersistentTreeMapStats<K,V,A,C>&
+PersistentTreeMapStats<K,V,A,C>::operator=(PersistentTreeMapStats&& m) {
+  if (&m == this) return *this;
+  release(root);
+  root = m.root;
+  n = m.n;
+  this->comp = m.comp;
+  m.root = NULL;
+  m.n = 0;
+  return *this;
+}
+
+/*
+  # INPUT: a key-value pair k and v
+  # POSTCONDITION: the map maps k to v; snapshots taken before are unchanged
+*/
+template <class K, class V, class A, class C>
+void
+PersistentTreeMapStats<K,V,A,C>::put(const K& k, const V& v) {
+  bool added = false;
+  root = this->putAux(root, k, v, added);
+  if (added) n++;
+}
+
+/*
+  # INPUT: a key k
+  # OUTPUT: true iff k was in the map
+  # POSTCONDITION: the map does not contain k; snapshots taken before are unchanged
+*/
+template <class K, class V, class A, class C>
+bool
+PersistentTreeMapStats<K,V,A,C>::erase(const K& k) {
+  if (!this->findNode(root, k)) return false;
+  root = this->eraseAux(root, k);
+  n--;
+  return true;
+}
+
+// utility/aux function to print out a parenthetic string representation of the entries in the subtree rooted at w
+template <class K, class V, class A, class C>
+void
+PersistentTreeMapStats<K,V,A,C>::printAux(std::ostream& os, const Node* w) {
+  eulerTour(w, [&os](const Node* x, TourStep step, int) {
+    if (step == TOUR_PRE) os << "[" << x->key << ":" << x->value << "](";
+    else if (step == TOUR_IN) os << "),(";
+    else os << ")";
+  });
+}
+
+#endif // PERSISTENT_TREE_MAP_STATS_H
@@ -0,0 +1,54 @@
+/*
+# Purpose: Benchmark of the overflow-safe aggregates: put and erase throughput of TreeMapStats (64-bit sum) and of
+# BasicTreeMapStats with each aggregate that tracks the wraps of its sums (see wrappingAdd), with int values and
+# with uint64_t values over their whole range (whose sums do wrap)
+# USAGE: AggregateBench [keys]   (default 1000000: that many puts of shuffled keys, then erases of all of them;
+# best of 3 runs)
+# RESULTS (g++ 12 -O2, 1-core Xeon VM with 5 GB; ranges over repeated runs):
+#   map                                      now         int sums     saturating
+#   TreeMapStats                             0.87-1.31   0.82-1.20    0.86-1.02
+#   BasicTreeMapStats<int,int>               1.05-1.13   0.97-1.23    0.95-1.04
+#   BasicTreeMapStats<int,int,Moments>       0.95-1.00       -        0.97-1.00
+#   BasicTreeMapStats<int,uint64_t>          0.84-1.01   0.81-1.00    0.81-0.95
+#   BasicTreeMapStats<int,uint64_t,Moments>  0.70-0.86       -        0.88-1.05
+# NOTE: (in Mops/s) "int sums" is the same source built against the commit before user-008 (sums in V, which
+# wrap silently; no MomentsAggregate), and "saturating" against the first version of user-008 (sums stuck at
+# the limit of S on overflow, which broke associativity); only tracking the wraps of the 64-bit sum of
+# squares, which needs a 128-bit product per reset, costs more than this machine's noise
+*/
+
+#include <cstdint>
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "../BasicTreeMapStats.h"
+#include "BenchUtil.h"
+
+// POSTCONDITION: prints the best throughput of putting the keys into a new Map (with random values) and then erasing them
+template <class Map, class V>
+void run(const char* name, const vector<int>& keys, const vector<int>& order) {
+  size_t n = keys.size();
+  vector<V> values(n);
+  mt19937_64 rng(3);
+  for (size_t i = 0; i < n; i++) values[i] = (V) rng();
+  Map* m = NULL;
+  double t = bestOf(3, [&]() { delete m; m = new Map(); }, [&]() {
+    for (size_t i = 0; i < n; i++) m->put(keys[i], values[i]);
+    for (size_t i = 0; i < n; i++) m->erase(order[i]);
+  });
+  printf("%-44s %8.2f\n", name, 2 * n / t / 1e6);
+  delete m;
+}
+
+int main(int argc, char** argv) {
+  int n = (int) argOr(argc, argv, 1, 1000000);
+  vector<int> keys = shuffledKeys(n, 1);
+  vector<int> order = shuffledKeys(n, 2);
+  printf("%-44s %8s\n", "map", "Mops/s");
+  run<TreeMapStats, int>("TreeMapStats", keys, order);
+  run<BasicTreeMapStats<int, int>, int>("BasicTreeMapStats<int,int>", keys, order);
+  run<BasicTreeMapStats<int, int, MomentsAggregate<int> >, int>("BasicTreeMapStats<int,int,Moments>", keys, order);
+  run<BasicTreeMapStats<int, uint64_t>, uint64_t>("BasicTreeMapStats<int,uint64_t>", keys, order);
+  run<BasicTreeMapStats<int, uint64_t, MomentsAggregate<uint64_t> >, uint64_t>("BasicTreeMapStats<int,uint64_t,Moments>", keys, order);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+/*
+# Purpose: Benchmark of TreeMapStats::applyBatch against a loop of put and erase: nanoseconds per update of
+# random updates (1 in 4 an erase, keys in [0, 2 keys)) applied in batches of B to a bulk-loaded map
+# USAGE: BatchBench [keys [updates]]   (default 10000000 keys 0, 1, ..., keys - 1, and 1000000 updates per
+# batch size, or one batch if B is larger)
+# RESULTS (g++ 12 -O2, 1-core Xeon VM with 5 GB; ranges over repeated runs):
+#   B          applyBatch ns    per-op loop ns
+#   1          1895-1951        1915-2002
+#   64         1782-1930        1699-1790
+#   4096       1605-1637        1834-1930
+#   65536      1104-1146        2173-2214
+#   1000000    393-397          1871-2081
+# NOTE: the time of applyBatch includes sorting each batch; below 1/SPARSE_BATCH updates per entry (here, up
+# to B = 625000), a batch is applied one update at a time in order of keys, which only saves cache misses at the
+# top of the search paths
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "BenchUtil.h"
+
+/*
+  # INPUT: sorted map entries; the batches of updates; a flag, batched, true to apply them with applyBatch,
+  # false with a loop of put and erase
+  # OUTPUT: the nanoseconds per update taken to apply the batches, in order, to a map of the entries
+*/
+static double updateTime(const vector<pair<int,int> >& entries, const vector<vector<AVLTreeMap::Op> >& batches,
+                         bool batched) {
+  TreeMapStats m;
+  m.bulkLoad(entries, true);
+  size_t updates = 0;
+  double t = timeOf([&]() {
+    for (const vector<AVLTreeMap::Op>& ops : batches) {
+      if (batched) m.applyBatch(ops);
+      else for (const AVLTreeMap::Op& op : ops) {
+        if (op.erase) m.erase(op.key);
+        else m.put(op.key, op.value);
+      }
+      updates += ops.size();
+    }
+  });
+  return t / updates * 1e9;
+}
+
+int main(int argc, char** argv) {
+  int n = (int) argOr(argc, argv, 1, 10000000);
+  long updates = argOr(argc, argv, 2, 1000000);
+  vector<pair<int,int> > entries(n);
+  for (int k = 0; k < n; k++) entries[k] = make_pair(k, k);
+  mt19937_64 rng(18);
+  printf("%-10s %16s %16s\n", "B", "applyBatch ns", "per-op loop ns");
+  long sizes[] = { 1, 64, 4096, 65536, 1000000 };
+  for (long b : sizes) {
+    vector<vector<AVLTreeMap::Op> > batches(max(1L, updates / b));
+    for (vector<AVLTreeMap::Op>& ops : batches) {
+      ops.resize(b);
+      for (AVLTreeMap::Op& op : ops) {
+        op.key = (int) (rng() % (2 * (uint64_t) n));
+        op.value = (int) rng();
+        op.erase = (rng() % 4 == 0);
+      }
+    }
+    double batched = updateTime(entries, batches, true);
+    double loop = updateTime(entries, batches, false);
+    printf("%-10ld %16.0f %16.0f\n", b, batched, loop);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+/*
+# Purpose: Shared utilities of the benchmarks: timing, random inputs and heap usage
+# NOTE: each benchmark is a program that prints its measurements as a table (see the Makefile: make bench); the
+# results recorded at the top of each source were measured on one machine, and are only comparable to each other
+*/
+
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+// OUTPUT: the seconds elapsed since t0
+inline double secondsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// OUTPUT: the seconds taken by a call of f
+template <class F>
+double timeOf(F f) {
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  f();
+  return secondsSince(t0);
+}
+
+// OUTPUT: the least of the seconds taken by runs calls of f, each after a call of setup (not timed)
+template <class Setup, class F>
+double bestOf(int runs, Setup setup, F f) {
+  double best = 1e300;
+  for (int i = 0; i < runs; i++) {
+    setup();
+    best = std::min(best, timeOf(f));
+  }
+  return best;
+}
+
+// OUTPUT: the keys 0, 1, ..., n - 1 in random order
+inline std::vector<int> shuffledKeys(int n, unsigned seed = 1) {
+  std::vector<int> keys(n);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937_64(seed));
+  return keys;
+}
+
+// OUTPUT: the bytes of heap memory in use (allocated and not freed, including allocator overhead per block)
+inline size_t heapBytes() {
+  struct mallinfo2 m = mallinfo2();
+  return m.uordblks + m.hblkhd;
+}
+
+// OUTPUT: the number given as argument i of the program, or def if there is none
+inline long argOr(int argc, char** argv, int i, long def) {
+  return argc > i ? atol(argv[i]) : def;
+}
+
+// OUTPUT: the path of a new empty temporary directory
+inline std::string tempDir() {
+  char tmpl[] = "/tmp/bench-XXXXXX";
+  if (!mkdtemp(tmpl)) {
+    perror("mkdtemp");
+    exit(EXIT_FAILURE);
+  }
+  return tmpl;
+}
+
+/*
+  # INPUT: the path of a driver program (as built from Main.cpp by make); a directory holding its input.txt; the
+  # path of a file for its output
+  # OUTPUT: the seconds taken by the driver to run the commands of input.txt (or -1 if it failed)
+  # NOTE: the driver path is taken relative to the current directory, not to dir
+*/
+inline double runDriver(const std::string& driver, const std::string& dir, const std::string& out) {
+  char* path = realpath(driver.c_str(), NULL);
+  if (!path) return -1;
+  std::string cmd = "cd '" + dir + "' && '" + path + "' > '" + out + "'";
+  free(path);
+  int status = 0;
+  double t = timeOf([&]() { status = system(cmd.c_str()); });
+  return status == 0 ? t : -1;
+}
+
+#endif // BENCH_UTIL_H
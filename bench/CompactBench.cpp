@@ -0,0 +1,72 @@
+/*
+# Purpose: Benchmark of CompactTreeMapStats (32-bit index links in one node array) against the pointer-based
+# stats maps: heap bytes per entry, and mean latency of finds of random present keys, for maps filled by puts
+# of shuffled keys (CompactTreeMapStats reserved first)
+# USAGE: CompactBench [keys]   (default 10000000; at 100000000, only CompactTreeMapStats<Count> fits in 5 GB, so
+# the others are skipped when keys > 20000000)
+# RESULTS (g++ 12 -O2, 1-core Xeon VM with 5 GB, 4 KB pages; ranges over repeated runs):
+#   keys        map                           B/entry   find ns
+#   10000000    TreeMapStats                     72     748-867
+#   10000000    BasicTreeMapStats                72     647-755
+#   10000000    CompactTreeMapStats              48     1028-1057
+#   10000000    BasicTreeMapStats<Count>         48     684-749
+#   10000000    CompactTreeMapStats<Count>       24     1359-1638
+#   100000000   CompactTreeMapStats<Count>       24     1624 (2.4 GB)
+# NOTE: the random descent is bound by cache and TLB misses, so the smaller nodes do not speed up find: the
+# index-to-address step on each level cancels the better cache fit, and the 24-byte nodes of
+# CompactTreeMapStats<Count> are slower still than its 32-byte nodes with a 64-bit count were (837-896 ns),
+# as one node in eight straddles two cache lines; the compact maps save a third (stats) or a half (count)
+# of the memory at the cost of find latency; 500M keys would take 12 GB even at 24 bytes per entry, more
+# than this machine has
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "../BasicTreeMapStats.h"
+#include "../CompactTreeMapStats.h"
+#include "BenchUtil.h"
+
+// POSTCONDITION: the node array of a CompactTreeMapStats has room for n entries (other maps allocate per node)
+template <class Map>
+void reserveFor(Map&, size_t) { }
+template <class K, class V, class A, class C>
+void reserveFor(CompactTreeMapStats<K, V, A, C>& m, size_t n) { m.reserve(n); }
+
+/*
+  # INPUT: the name of a map class; shuffled keys
+  # POSTCONDITION: prints the heap bytes per entry of a new Map holding the keys, and the mean nanoseconds per
+  # find of 1M random keys among them
+*/
+template <class Map>
+void run(const char* name, const vector<int>& keys) {
+  size_t n = keys.size();
+  size_t before = heapBytes();
+  Map* m = new Map();
+  reserveFor(*m, n);
+  for (size_t i = 0; i < n; i++) m->put(keys[i], (int) i);
+  size_t bytes = heapBytes() - before;
+  mt19937_64 rng(24);
+  vector<int> probes(1000000);
+  for (size_t i = 0; i < probes.size(); i++) probes[i] = keys[rng() % n];
+  size_t found = 0;
+  double t = timeOf([&]() {
+    for (size_t i = 0; i < probes.size(); i++) found += !!m->find(probes[i]);
+  });
+  printf("%-34s %8.1f %8.0f%s\n", name, (double) bytes / n, t / probes.size() * 1e9,
+         found == probes.size() ? "" : " (wrong)");
+  delete m;
+}
+
+int main(int argc, char** argv) {
+  int n = (int) argOr(argc, argv, 1, 10000000);
+  vector<int> keys = shuffledKeys(n, 24);
+  printf("%-34s %8s %8s\n", "map", "B/entry", "find ns");
+  if (n <= 20000000) {
+    run<TreeMapStats>("TreeMapStats", keys);
+    run<BasicTreeMapStats<int, int> >("BasicTreeMapStats", keys);
+    run<CompactTreeMapStats<int, int> >("CompactTreeMapStats", keys);
+    run<BasicTreeMapStats<int, int, CountAggregate> >("BasicTreeMapStats<Count>", keys);
+  }
+  run<CompactTreeMapStats<int, int, CompactCountAggregate> >("CompactTreeMapStats<Count>", keys);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,122 @@
+/*
+# Purpose: Benchmark of ConcurrentTreeMapStats (lock-free readers) against BasicTreeMapStats behind a
+# shared_mutex: throughput of R reader threads doing random finds while one writer thread does random puts and
+# erases, for R = 1, 4, 16, 64
+# USAGE: ConcurrentBench [keys [millis]]   (default 1000000 keys, 1000 ms per point)
+# RESULTS (g++ 12 -O2, 1-core Xeon VM with 5 GB; ranges over repeated runs):
+#   readers   concurrent: Mfind/s   writes/s     shared_mutex: Mfind/s   writes/s
+#   1                     0.91-1.13  144k-168k                 0.81-0.90  302k-330k
+#   4                     1.29-1.60  70k-84k                   1.29-2.07  1
+#   16                    1.17-2.29  16k-29k                   1.24-2.37  1
+#   64                    1.19-2.50  4.8k-7.8k                 1.28-1.97  1
+# NOTE: with one core, this measures interleaving and fairness, not scaling: with 4 readers or more, the
+# readers starve the writer of the shared_mutex, while the readers of the concurrent map never block its
+# writer, which only shares the core with them; the finds go to an atomic counter of hits, or the compiler
+# may drop them
+*/
+
+#include <atomic>
+#include <shared_mutex>
+#include <thread>
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "../BasicTreeMapStats.h"
+#include "../ConcurrentTreeMapStats.h"
+#include "BenchUtil.h"
+
+typedef ConcurrentTreeMapStats<int, int> ConcurrentMap;
+
+// BasicTreeMapStats with a shared_mutex: finds take it shared, updates exclusive
+class LockedMap
+{
+public:
+  class Reader {
+  public:
+    explicit Reader(const LockedMap& m) : map(m) { };
+    bool find(int k) const {
+      std::shared_lock<std::shared_mutex> lock(map.lock);
+      return map.map.find(k) != NULL;
+    };
+  private:
+    const LockedMap& map;
+  };
+  void put(int k, int v) {
+    std::unique_lock<std::shared_mutex> lock(this->lock);
+    map.put(k, v);
+  };
+  void erase(int k) {
+    std::unique_lock<std::shared_mutex> lock(this->lock);
+    map.erase(k);
+  };
+private:
+  BasicTreeMapStats<int, int> map;
+  mutable std::shared_mutex lock;
+};
+
+/*
+  # INPUT: a map holding the keys 0, 1, ..., keys - 1; a number of reader threads; the milliseconds to run
+  # POSTCONDITION: prints the finds per second of all the readers together (each holding a Reader of m), the
+  # share of them that found their key, and the updates per second of the writer (random puts and erases of
+  # the same keys, half each)
+*/
+template <class Map>
+void run(const char* name, Map& m, int keys, int readers, int millis) {
+  std::atomic<bool> start(false), stop(false);
+  std::atomic<long> finds(0), hits(0);
+  long writes = 0;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < readers; i++) {
+    threads.emplace_back([&, i]() {
+      typename Map::Reader r(m);
+      mt19937_64 rng(100 + i);
+      long found = 0, count = 0;
+      while (!start.load()) std::this_thread::yield();
+      while (!stop.load(std::memory_order_relaxed)) {
+        for (int j = 0; j < 64; j++) found += r.find((int) (rng() % keys));
+        count += 64;
+      }
+      finds += count;
+      hits += found;
+    });
+  }
+  threads.emplace_back([&]() {
+    mt19937_64 rng(99);
+    while (!start.load()) std::this_thread::yield();
+    while (!stop.load(std::memory_order_relaxed)) {
+      int k = (int) (rng() % keys);
+      if (rng() % 2) m.put(k, k);
+      else m.erase(k);
+      writes++;
+    }
+  });
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  start = true;
+  std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+  stop = true;
+  double t = secondsSince(t0);
+  for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+  printf("%-14s %8d %10.2f %8.0f %12.0f\n", name, readers, finds / t / 1e6, 100.0 * hits / max(1L, finds.load()),
+         writes / t);
+}
+
+int main(int argc, char** argv) {
+  int n = (int) argOr(argc, argv, 1, 1000000);
+  int millis = (int) argOr(argc, argv, 2, 1000);
+  vector<int> keys = shuffledKeys(n, 19);
+  ConcurrentMap* concurrent = new ConcurrentMap();
+  LockedMap* locked = new LockedMap();
+  for (int i = 0; i < n; i++) {
+    concurrent->put(keys[i], keys[i]);
+    locked->put(keys[i], keys[i]);
+  }
+  printf("%-14s %8s %10s %8s %12s\n", "map", "readers", "Mfind/s", "found %", "writes/s");
+  int readers[] = { 1, 4, 16, 64 };
+  for (int r : readers) {
+    run("concurrent", *concurrent, n, r, millis);
+    run("shared_mutex", *locked, n, r, millis);
+  }
+  delete concurrent;
+  delete locked;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,59 @@
+/*
+# Purpose: Benchmark of TreeMapStats::eraseRange against a loop of erase over the same keys: mean time to erase a
+# window of contiguous keys at a random position of a bulk-loaded map (the keys are put back between erasures,
+# untimed)
+# USAGE: EraseRangeBench [keys]   (default 10000000: the keys 0, 1, ..., keys - 1)
+# RESULTS (g++ 12 -O2, 1-core Xeon VM with 5 GB; ranges over repeated runs):
+#   window     eraseRange us    per-key loop us
+#   1          2.7-3.5          2.4-3.0
+#   17         6.4-8.5          7.4-9.3
+#   100        10.2-13.9        27.3-36.9
+#   10000      405-466          2150-2730
+#   1000000    33800-39400      178000-249000
+# NOTE: up to SMALL_RANGE (16) keys, eraseRange erases key by key too, after a walk of the range; the two
+# methods erase at different random positions, or the second one would find the paths of the first cached
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "BenchUtil.h"
+
+/*
+  # INPUT: a map; a window size; a number of repetitions; a flag, ranged, true to erase with eraseRange, false
+  # with a loop of erase
+  # OUTPUT: the mean microseconds taken to erase a window of contiguous keys of m at a random position
+  # POSTCONDITION: m holds the same keys as before (with values equal to their keys)
+*/
+static double eraseTime(TreeMapStats& m, int window, int reps, bool ranged) {
+  mt19937_64 rng(ranged ? 17 : 18);
+  int n = m.size();
+  double total = 0;
+  for (int r = 0; r < reps; r++) {
+    int lo = (int) (rng() % (n - window + 1));
+    int hi = lo + window - 1;
+    total += timeOf([&]() {
+      if (ranged) m.eraseRange(lo, hi);
+      else for (int k = lo; k <= hi; k++) m.erase(k);
+    });
+    for (int k = lo; k <= hi; k++) m.put(k, k);
+  }
+  return total / reps * 1e6;
+}
+
+int main(int argc, char** argv) {
+  int n = (int) argOr(argc, argv, 1, 10000000);
+  vector<pair<int,int> > entries(n);
+  for (int k = 0; k < n; k++) entries[k] = make_pair(k, k);
+  TreeMapStats m;
+  m.bulkLoad(entries, true);
+  printf("%-10s %16s %16s\n", "window", "eraseRange us", "per-key loop us");
+  int windows[] = { 1, 17, 100, 10000, 1000000 };
+  for (int w : windows) {
+    if (w > n / 2) break;
+    int reps = max(3, min(1000, 1000000 / w));
+    double ranged = eraseTime(m, w, reps, true);
+    double loop = eraseTime(m, w, reps, false);
+    printf("%-10d %16.1f %16.1f\n", w, ranged, loop);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,43 @@
+/*
+# Purpose: Benchmark of the node pool of the maps: throughput of put/erase churn (each pair allocates one node
+# and frees one) on a TreeMapStats of steady size, and the time to destroy a large TreeMapStats
+# USAGE: NodePoolBench [keys [teardown keys]]   (default 1000000 keys for churn, 50000000 for teardown)
+# RESULTS (g++ 12 -O2, 1-core Xeon VM with 5 GB; ranges over repeated runs):
+#   measure                          node pool      first version
+#   churn, 1M entries (Mpairs/s)     0.28-0.33      0.26-0.31
+#   churn, 1000 entries (Mpairs/s)   3.81           2.41
+#   teardown, 5M entries (s)         0.019          1.293
+#   teardown, 50M entries (s)        0.436          17.928
+# NOTE: "first version" is the same source built against Main.cpp of user-001 (one new/delete per node; with
+# the guard of main() added); churn on a large map is bound by the cache misses of the descents, so the pool
+# shows in small maps and above all in teardown, which releases the pool in bulk instead of node by node
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "BenchUtil.h"
+
+int main(int argc, char** argv) {
+  int n = (int) argOr(argc, argv, 1, 1000000);
+  int t = (int) argOr(argc, argv, 2, 50000000);
+  // churn: a window of n keys slides over 2n shuffled keys, putting the next key and erasing the oldest
+  vector<int> keys = shuffledKeys(2 * n, 2);
+  TreeMapStats* m = new TreeMapStats();
+  for (int i = 0; i < n; i++) m->put(keys[i], i);
+  double churn = timeOf([&]() {
+    for (int i = 0; i < n; i++) {
+      m->put(keys[n + i], i);
+      m->erase(keys[i]);
+    }
+  });
+  printf("churn of %d entries: %.2f Mpairs/s%s\n", n, n / churn / 1e6, m->size() == n ? "" : " (wrong)");
+  delete m;
+  // teardown of t entries (put in random order)
+  keys = shuffledKeys(t, 3);
+  m = new TreeMapStats();
+  for (int i = 0; i < t; i++) m->put(keys[i], i);
+  vector<int>().swap(keys);
+  double teardown = timeOf([&]() { delete m; });
+  printf("teardown of %d entries: %.3f s\n", t, teardown);
+  return EXIT_SUCCESS;
+}
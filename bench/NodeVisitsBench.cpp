@@ -0,0 +1,45 @@
+/*
+# Purpose: Benchmark of the single upward pass of TreeMapStats (rebalancing and stats maintenance together): the
+# nodes reset per put and per erase (see TreeMapStats::nodeVisits), and the throughput of random puts and erases
+# USAGE: NodeVisitsBench [keys]   (default 1000000: that many puts of shuffled keys, then erases of all of them)
+# RESULTS (g++ 12 -O2, 1-core Xeon VM with 5 GB; ranges over repeated runs):
+#   keys      op      resets/op   Mops/s
+#   1000000   put        19.8     0.73-0.96
+#   1000000   erase      18.2     0.67-0.89
+#   10000000  put        23.2     0.39
+#   10000000  erase      21.6     0.38
+# NOTE: before user-005 (stats reset by a separate walk to the root after each update and each rotation), the
+# same updates made 36.1 resets per put (32.4 of stats, 3.7 of heights) and 27.2 per erase (24.8 and 2.4),
+# counted by instrumenting Main.cpp of the commit before it; its throughput, 0.72-0.96 (put) and 0.70-0.89 (erase) Mops/s
+# at 1M keys and 0.43 and 0.38 at 10M, is within the noise of this machine: the resets saved hit nodes that the
+# search has just brought into the cache
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "BenchUtil.h"
+
+int main(int argc, char** argv) {
+  int n = (int) argOr(argc, argv, 1, 1000000);
+  vector<int> keys = shuffledKeys(n, 1);
+  vector<int> order = shuffledKeys(n, 2);
+  TreeMapStats* m = new TreeMapStats();
+  long long putVisits = 0, eraseVisits = 0;
+  double putTime = timeOf([&]() {
+    for (int i = 0; i < n; i++) {
+      m->put(keys[i], i);
+      putVisits += m->nodeVisits();
+    }
+  });
+  double eraseTime = timeOf([&]() {
+    for (int i = 0; i < n; i++) {
+      m->erase(order[i]);
+      eraseVisits += m->nodeVisits();
+    }
+  });
+  printf("%-9s %-6s %14s %8s\n", "keys", "op", "resets/op", "Mops/s");
+  printf("%-9d %-6s %14.1f %8.2f\n", n, "put", (double) putVisits / n, n / putTime / 1e6);
+  printf("%-9d %-6s %14.1f %8.2f\n", n, "erase", (double) eraseVisits / n, n / eraseTime / 1e6);
+  delete m;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,54 @@
+/*
+# Purpose: Benchmark of the output of the driver program: replay of a find-heavy command file (100K puts, then
+# finds, then print_stats_tree of the map), with echo on and the output redirected to a file (best of 3 runs)
+# USAGE: OutputBench [finds [driver]]   (default 5000000 finds, and ./main; run from the repository root)
+# RESULTS (g++ 12 -O2, 1-core Xeon VM with 5 GB; ranges over repeated runs):
+#   driver    output MB   seconds
+#   now         116.7     1.65-1.69
+#   before      116.7     8.32-10.30
+# NOTE: "before" is this benchmark run with a driver built from Main.cpp of the commit before user-011, which
+# wrote each echoed command and reply to cout with endl (a write system call per line)
+*/
+
+#include <string>
+
+#include "BenchUtil.h"
+
+// POSTCONDITION: dir holds an input.txt of 100K puts of shuffled keys, finds of random keys (half of them
+// absent) and a print_stats_tree
+static void writeCommands(const std::string& dir, long finds) {
+  FILE* f = fopen((dir + "/input.txt").c_str(), "w");
+  std::vector<int> keys = shuffledKeys(100000, 11);
+  for (size_t i = 0; i < keys.size(); i++) fprintf(f, "put %d %d\n", keys[i], (int) i);
+  std::mt19937_64 rng(11);
+  for (long i = 0; i < finds; i++) fprintf(f, "find %d\n", (int) (rng() % 200000));
+  fprintf(f, "print_stats_tree\n");
+  fclose(f);
+}
+
+int main(int argc, char** argv) {
+  long finds = argOr(argc, argv, 1, 5000000);
+  std::string driver = argc > 2 ? argv[2] : "./main";
+  std::string dir = tempDir();
+  std::string out = dir + "/output.txt";
+  writeCommands(dir, finds);
+  double best = 1e300;
+  for (int r = 0; r < 3; r++) {
+    double t = runDriver(driver, dir, out);
+    if (t < 0) {
+      fprintf(stderr, "cannot run %s\n", driver.c_str());
+      return EXIT_FAILURE;
+    }
+    best = std::min(best, t);
+  }
+  FILE* f = fopen(out.c_str(), "r");
+  fseek(f, 0, SEEK_END);
+  long bytes = ftell(f);
+  fclose(f);
+  printf("%-10s %12s %10s\n", "finds", "output MB", "seconds");
+  printf("%-10ld %12.1f %10.2f\n", finds, bytes / 1e6, best);
+  remove((dir + "/input.txt").c_str());
+  remove(out.c_str());
+  rmdir(dir.c_str());
+  return EXIT_SUCCESS;
+}
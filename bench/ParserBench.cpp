@@ -0,0 +1,61 @@
+/*
+# Purpose: Benchmark of the command parser of the driver program: replay of a long command file by the driver
+# (built from Main.cpp), with its output discarded, in millions of lines per second (best of 3 runs)
+# USAGE: ParserBench [lines [driver]]   (default 5000000 lines, and ./main; run from the repository root)
+# RESULTS (g++ 12 -O2, 1-core Xeon VM with 5 GB; ranges over repeated runs):
+#   workload              now         before
+#   put/erase only        3.77-5.36   0.72-1.09
+#   with find replies     4.62-5.75   0.82-1.01
+# NOTE: "before" is this benchmark run with a driver built from Main.cpp of the commit before user-010 (getline,
+# a stringstream and a vector of string tokens per line); with a map of 1000 keys, the replay is bound by the
+# parser, and the replies of find (half of the second workload) cost less than the updates they replace
+*/
+
+#include <string>
+
+#include "BenchUtil.h"
+
+/*
+  # INPUT: a directory; a number of lines; the share of find commands among them (the others are puts and
+  # erases, 3 to 1), in percent
+  # POSTCONDITION: dir holds an input.txt of noecho and the given number of random commands on 1000 keys (a
+  # small map, so that the replay time is mostly that of reading and parsing)
+*/
+static void writeCommands(const std::string& dir, long lines, int findPercent) {
+  FILE* f = fopen((dir + "/input.txt").c_str(), "w");
+  std::mt19937_64 rng(10);
+  fprintf(f, "noecho\n");
+  for (long i = 0; i < lines; i++) {
+    int k = (int) (rng() % 1000);
+    int r = (int) (rng() % 100);
+    if (r < findPercent) fprintf(f, "find %d\n", k);
+    else if (r % 4 == 0) fprintf(f, "erase %d\n", k);
+    else fprintf(f, "put %d %d\n", k, (int) (rng() % 2000001) - 1000000);
+  }
+  fclose(f);
+}
+
+int main(int argc, char** argv) {
+  long lines = argOr(argc, argv, 1, 5000000);
+  std::string driver = argc > 2 ? argv[2] : "./main";
+  std::string dir = tempDir();
+  printf("%-22s %12s\n", "workload", "M lines/s");
+  const char* names[] = { "put/erase only", "with find replies" };
+  int finds[] = { 0, 50 };
+  for (int w = 0; w < 2; w++) {
+    writeCommands(dir, lines, finds[w]);
+    double best = 1e300;
+    for (int r = 0; r < 3; r++) {
+      double t = runDriver(driver, dir, "/dev/null");
+      if (t < 0) {
+        fprintf(stderr, "cannot run %s\n", driver.c_str());
+        return EXIT_FAILURE;
+      }
+      best = std::min(best, t);
+    }
+    printf("%-22s %12.2f\n", names[w], lines / best / 1e6);
+  }
+  remove((dir + "/input.txt").c_str());
+  rmdir(dir.c_str());
+  return EXIT_SUCCESS;
+}
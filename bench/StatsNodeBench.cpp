@@ -0,0 +1,39 @@
+/*
+# Purpose: Benchmark of the TreeMapStats node, whose stats are stored inline (one allocation per entry): heap
+# bytes per entry, and put throughput of shuffled keys, next to AVLTreeMap (the same node with no stats)
+# USAGE: StatsNodeBench [keys]   (default 1000000)
+# RESULTS (g++ 12 -O2, 1-core Xeon VM with 5 GB; ranges over repeated runs):
+#   keys      map           bytes/entry  put Mops/s
+#   1000000   AVLTreeMap        49       1.13-1.44
+#   1000000   TreeMapStats      72       0.75-0.94
+#   10000000  AVLTreeMap        48       0.55
+#   10000000  TreeMapStats      72       0.37
+# NOTE: the same source built against Main.cpp of the baseline commit (stats in a separate heap object, and
+# plain new/delete; with the guard of main() added) gives TreeMapStats 96 bytes/entry at 0.62-0.63 (1M) and
+# 0.35 (10M) Mops/s; the inline node is 72 bytes, not 80, since user-025 made the node pool size classes finer
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "BenchUtil.h"
+
+// POSTCONDITION: prints the heap bytes per entry and the put throughput of keys into a new Map
+template <class Map>
+void run(const char* name, const vector<int>& keys) {
+  size_t before = heapBytes();
+  Map* m = new Map();
+  double t = timeOf([&]() {
+    for (size_t i = 0; i < keys.size(); i++) m->put(keys[i], (int) i);
+  });
+  size_t bytes = heapBytes() - before;
+  printf("%-9zu %-13s %8.0f %12.2f\n", keys.size(), name, (double) bytes / keys.size(), keys.size() / t / 1e6);
+  delete m;
+}
+
+int main(int argc, char** argv) {
+  vector<int> keys = shuffledKeys((int) argOr(argc, argv, 1, 1000000));
+  printf("%-9s %-13s %8s %12s\n", "keys", "map", "bytes/entry", "put Mops/s");
+  run<AVLTreeMap>("AVLTreeMap", keys);
+  run<TreeMapStats>("TreeMapStats", keys);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,55 @@
+/*
+# Purpose: Benchmark of the devirtualized template maps (BasicAVLTreeMap, BasicTreeMapStats: CRTP hooks, no
+# vtable pointer per node) next to the virtual-hook maps of Main.cpp (AVLTreeMap, TreeMapStats): heap bytes per
+# entry, and throughput of a mix of random puts, finds and erases
+# USAGE: TemplateMapBench [keys]   (default 1000000: that many puts and finds, then half as many erases)
+# RESULTS (g++ 12 -O2, 1-core Xeon VM with 5 GB; ranges over repeated runs):
+#   map                          B/entry   Mops/s
+#   AVLTreeMap                      49     1.92-2.43
+#   BasicAVLTreeMap<int,int>        40     2.24-2.63
+#   TreeMapStats                    72     1.10-1.53
+#   BasicTreeMapStats<int,int>      72     1.17-1.55
+# NOTE: without its vtable pointer, the AVL node saves 8 bytes and runs 5-15% faster; the stats node saves the
+# vtable pointer but holds a wider aggregate (a size_t count, and the wrap count of the sum added by user-008),
+# so both stats maps take 72 bytes and run within noise of each other
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "../BasicTreeMapStats.h"
+#include "BenchUtil.h"
+
+/*
+  # INPUT: the name of a map class; random keys
+  # POSTCONDITION: prints the heap bytes per entry of a new Map holding all the keys, and the throughput (in
+  # millions of operations per second) of putting the keys, finding them, and erasing half of them
+*/
+template <class Map>
+void run(const char* name, const vector<int>& keys, const vector<int>& order) {
+  size_t n = keys.size();
+  size_t before = heapBytes();
+  Map* m = new Map();
+  double t = timeOf([&]() {
+    for (size_t i = 0; i < n; i++) m->put(keys[i], (int) i);
+  });
+  size_t bytes = heapBytes() - before;
+  size_t found = 0;
+  t += timeOf([&]() {
+    for (size_t i = 0; i < n; i++) found += (m->find(order[i]) != NULL);
+    for (size_t i = 0; i < n / 2; i++) m->erase(order[i]);
+  });
+  printf("%-28s %8.0f %10.2f%s\n", name, (double) bytes / n, (2 * n + n / 2) / t / 1e6, found == n ? "" : " (wrong)");
+  delete m;
+}
+
+int main(int argc, char** argv) {
+  int n = (int) argOr(argc, argv, 1, 1000000);
+  vector<int> keys = shuffledKeys(n, 1);
+  vector<int> order = shuffledKeys(n, 2);
+  printf("%-28s %8s %10s\n", "map", "B/entry", "Mops/s");
+  run<AVLTreeMap>("AVLTreeMap", keys, order);
+  run<BasicAVLTreeMap<int, int> >("BasicAVLTreeMap<int,int>", keys, order);
+  run<TreeMapStats>("TreeMapStats", keys, order);
+  run<BasicTreeMapStats<int, int> >("BasicTreeMapStats<int,int>", keys, order);
+  return EXIT_SUCCESS;
+}
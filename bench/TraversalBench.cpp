@@ -0,0 +1,68 @@
+/*
+# Purpose: Benchmark of the traversals of whole trees against tree size: full dump of a TreeMapStats (printMap
+# and printTreeMapStats, to an output sink on /dev/null), teardown of its nodes in postorder (as by clear
+# when the node pool is shared, or by eraseRange), and bulk teardown by the destructor; and the dump of a
+# degenerate 30K-deep BSTMap (sorted puts)
+# USAGE: TraversalBench [keys ...]   (default 1000000 5000000: one TreeMapStats of each size, random keys)
+# RESULTS (g++ 12 -O2, 1-core Xeon VM with 5 GB; ranges over repeated runs):
+#   map                    dump s        postorder s    destructor s
+#   TreeMapStats 1M        0.73-0.80     0.069-0.093    0.000
+#   TreeMapStats 5M        3.97-4.75     0.49-0.52      0.021-0.026
+#   BSTMap 30000-deep      0.002
+# NOTE: before user-012 (recursive printAux, printTreeAux and deleteNode), the same source, with the
+# postorder teardown made by the private deleteNode of the commit before it, measured 0.62-0.74 and 4.36-5.02 s
+# for the dumps, 0.068-0.072 and 0.56-0.59 s for the postorder teardowns, and 0.003-0.004 s for the deep dump:
+# the explicit stack costs nothing measurable, and removes the bound of the call stack on tree depth (the
+# recursive deep dump overflows a 512 KiB stack)
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "BenchUtil.h"
+
+// a TreeMapStats whose nodes can be destroyed by a postorder traversal, as a subtree detached from a map is
+class TeardownMap : public TreeMapStats
+{
+public:
+  // OUTPUT: the number of nodes destroyed
+  // POSTCONDITION: the map is empty
+  int destroyTree() {
+    BSTMap::Node* r = root;
+    setTree(NULL, 0);
+    return destroySubtree(r);
+  };
+};
+
+int main(int argc, char** argv) {
+  vector<long> sizes;
+  for (int i = 1; i < argc; i++) sizes.push_back(atol(argv[i]));
+  if (sizes.empty()) sizes = { 1000000, 5000000 };
+  FILE* devNull = fopen("/dev/null", "w");
+  OutputSink os(devNull);
+  printf("%-22s %10s %12s %14s\n", "map", "dump s", "postorder s", "destructor s");
+  for (size_t i = 0; i < sizes.size(); i++) {
+    vector<int> keys = shuffledKeys((int) sizes[i], 12);
+    TeardownMap* m = new TeardownMap();
+    for (size_t j = 0; j < keys.size(); j++) m->put(keys[j], (int) j);
+    double dump = timeOf([&]() {
+      m->setOutput(os);
+      m->printMap();
+      m->printTreeMapStats();
+      os.flush();
+    });
+    double post = timeOf([&]() { m->destroyTree(); });
+    for (size_t j = 0; j < keys.size(); j++) m->put(keys[j], (int) j);
+    double destructor = timeOf([&]() { delete m; });
+    printf("TreeMapStats %-9ld %10.3f %12.3f %14.3f\n", sizes[i], dump, post, destructor);
+  }
+  BSTMap deep;
+  for (int k = 0; k < 30000; k++) deep.put(k, k);
+  deep.setOutput(os);
+  double dump = timeOf([&]() {
+    deep.printMap();
+    deep.print();
+    os.flush();
+  });
+  printf("%-22s %10.3f\n", "BSTMap 30000-deep", dump);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+/*
+# Purpose: Tests of applyBatch of TreeMapStats: a batch of updates leaves the map as if they were applied one at a
+# time, in order (so the last update of a key wins), with a proper AVL tree and correct stats, whether the batch is
+# sparse (applied key by key) or dense (merged into the tree), sorted or not
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "TreeMapStatsCheck.h"
+
+/*
+  # INPUT: a number of updates; the bound, keys, of their keys; a random generator
+  # OUTPUT: random updates (1 in 3 an erase, of a key that may be absent), in random order, keys repeating
+*/
+static vector<AVLTreeMap::Op> randomOps(int m, int keys, mt19937_64& rng) {
+  uniform_int_distribution<int> key(0, keys - 1);
+  uniform_int_distribution<int> value(INT_MIN, INT_MAX);
+  vector<AVLTreeMap::Op> ops(m);
+  for (AVLTreeMap::Op& o : ops) {
+    o.key = key(rng);
+    o.value = value(rng);
+    o.erase = (rng() % 3 == 0);
+  }
+  return ops;
+}
+
+// POSTCONDITION: the updates are applied to the model, in order
+static void applyOps(map<int,int>& model, const vector<AVLTreeMap::Op>& ops) {
+  for (const AVLTreeMap::Op& o : ops) {
+    if (o.erase) model.erase(o.key);
+    else model[o.key] = o.value;
+  }
+}
+
+// batches of all densities, from a single update to many more updates than entries, into maps of all sizes
+static void testRandomBatches(mt19937_64& rng) {
+  for (int n : {0, 1, 100, 20000}) {
+    for (int m : {1, 10, 100, 1000, 5000, 50000}) {
+      map<int,int> model = randomEntries(n, 2 * n + 1, rng);
+      CheckedTreeMapStats t(model);
+      vector<AVLTreeMap::Op> ops = randomOps(m, 2 * n + 100, rng);
+      t.applyBatch(ops);
+      applyOps(model, ops);
+      assert(t.valid());
+      assert(entries(t) == model);
+      // a second batch, into the updated map
+      ops = randomOps(m, 2 * n + 100, rng);
+      t.applyBatch(ops);
+      applyOps(model, ops);
+      assert(t.valid() && entries(t) == model);
+    }
+  }
+}
+
+// batches already sorted by key (with no repeated key), passed as such
+static void testSortedBatches(mt19937_64& rng) {
+  for (int m : {1, 50, 3000}) {
+    map<int,int> model = randomEntries(10000, 20000, rng);
+    CheckedTreeMapStats t(model);
+    vector<AVLTreeMap::Op> ops;
+    for (int k = 0; k < 20000 && (int) ops.size() < m; k += 1 + rng() % 7)
+      ops.push_back(AVLTreeMap::Op{k, (int) rng(), rng() % 2 == 0});
+    t.applyBatch(ops, true);
+    applyOps(model, ops);
+    assert(t.valid() && entries(t) == model);
+  }
+}
+
+// the last update of a key wins, whatever the updates before it; erasing absent keys changes nothing
+static void testLastUpdateWins() {
+  for (int n : {0, 1000}) {
+    map<int,int> model;
+    for (int k = 0; k < n; k++) model[2 * k] = k;
+    // sparse (a few keys) and dense (every key) batches
+    for (int m : {3, 2 * n + 2}) {
+      CheckedTreeMapStats t(model);
+      map<int,int> expected(model);
+      vector<AVLTreeMap::Op> ops;
+      for (int k = 0; k < m; k++) {
+        ops.push_back(AVLTreeMap::Op{k, -1, false});
+        ops.push_back(AVLTreeMap::Op{k, 0, true});
+        if (k % 2) ops.push_back(AVLTreeMap::Op{k, k + 7, false});
+      }
+      // erases of keys that are not in the map
+      ops.push_back(AVLTreeMap::Op{-5, 0, true});
+      ops.push_back(AVLTreeMap::Op{4 * n + 5, 0, true});
+      t.applyBatch(ops);
+      applyOps(expected, ops);
+      assert(t.valid() && entries(t) == expected);
+    }
+  }
+  CheckedTreeMapStats t(map<int,int>{{1, 1}, {2, 2}, {3, 3}});
+  t.applyBatch(vector<AVLTreeMap::Op>{{5, 0, true}, {0, 0, true}});
+  assert(t.valid() && entries(t) == (map<int,int>{{1, 1}, {2, 2}, {3, 3}}));
+  t.applyBatch(vector<AVLTreeMap::Op>());
+  assert(t.valid() && t.size() == 3);
+}
+
+// a batch into an empty map builds it (puts only), and the erases in it are ignored
+static void testEmptyMap(mt19937_64& rng) {
+  CheckedTreeMapStats t;
+  vector<AVLTreeMap::Op> ops = randomOps(10000, 3000, rng);
+  t.applyBatch(ops);
+  map<int,int> model;
+  applyOps(model, ops);
+  assert(t.valid() && entries(t) == model);
+}
+
+// a sparse batch is applied by put and erase, in order of keys, so nodeVisits is that of its last update
+static void testSparseNodeVisits(mt19937_64& rng) {
+  map<int,int> model = randomEntries(20000, 40000, rng);
+  TreeMapStats a(vector<pair<int,int> >(model.begin(), model.end()), true);
+  TreeMapStats b(vector<pair<int,int> >(model.begin(), model.end()), true);
+  vector<AVLTreeMap::Op> ops = randomOps(200, 40000, rng);
+  a.applyBatch(ops);
+  map<int,AVLTreeMap::Op> last;
+  for (const AVLTreeMap::Op& o : ops) last[o.key] = o;
+  for (auto& x : last) {
+    if (x.second.erase) b.erase(x.first);
+    else b.put(x.first, x.second.value);
+  }
+  assert(entries(a) == entries(b));
+  assert(a.nodeVisits() == b.nodeVisits() && a.nodeVisits() > 0);
+}
+
+int main() {
+  mt19937_64 rng(18);
+  testRandomBatches(rng);
+  testSortedBatches(rng);
+  testLastUpdateWins();
+  testEmptyMap(rng);
+  testSparseNodeVisits(rng);
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
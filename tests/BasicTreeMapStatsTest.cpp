@@ -0,0 +1,113 @@
+/*
+# Purpose: Tests of BasicTreeMapStats, instantiated with int, unsigned and uint64_t values and with each
+# aggregate policy, and of the plain BST and AVL layers below it, against a std::map
+*/
+
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include <type_traits>
+
+#include "../BasicTreeMapStats.h"
+#include "MapModelCheck.h"
+
+// OUTPUT: true iff key k is in map m, in which case its value is stored in *v
+template <class Map, class V>
+bool findValue(const Map& m, int k, V* v) {
+  const typename Map::Node* w = m.find(k);
+  if (w) *v = w->value;
+  return w != NULL;
+}
+
+// random updates of a BasicTreeMapStats with the default aggregate (StatsAggregate), and values of type V
+template <class V>
+void testStats(std::mt19937_64& rng) {
+  typedef BasicTreeMapStats<int, V> Map;
+  Map m;
+  std::map<int,V> model;
+  checkRandomUpdates(m, model, findValue<Map, V>, 20000, 2000, rng, 1000,
+                     [](const Map& m, const std::map<int,V>& model) {
+                       checkStats(model, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), m.stats());
+                     });
+  m.clear();
+  assert(m.empty() && m.size() == 0 && m.stats().num == 0);
+}
+
+// the other aggregate policies, on the same updates
+static void testAggregates(std::mt19937_64& rng) {
+  typedef BasicTreeMapStats<int, uint64_t, SumAggregate<uint64_t> > SumMap;
+  typedef BasicTreeMapStats<int, int, CountAggregate> CountMap;
+  typedef BasicTreeMapStats<int, int, MomentsAggregate<int> > MomentsMap;
+  SumMap sums;
+  std::map<int,uint64_t> sumModel;
+  checkRandomUpdates(sums, sumModel, findValue<SumMap, uint64_t>, 5000, 500, rng, 500,
+                     [](const SumMap& m, const std::map<int,uint64_t>& model) {
+                       __int128 sum = 0;
+                       for (auto& e : model) sum += e.second;
+                       SumMap::Info s = m.stats();
+                       assert(exactSum(s.sum, s.wraps) == sum);
+                       assert(SumAggregate<uint64_t>::overflowed(s) == (sum > (__int128) UINT64_MAX));
+                     });
+  CountMap counts;
+  std::map<int,int> countModel;
+  checkRandomUpdates(counts, countModel, findValue<CountMap, int>, 5000, 500, rng, 500,
+                     [](const CountMap& m, const std::map<int,int>& model) { assert(m.stats() == model.size()); });
+  MomentsMap moments;
+  std::map<int,int> momentsModel;
+  checkRandomUpdates(moments, momentsModel, findValue<MomentsMap, int>, 5000, 500, rng, 500,
+                     [](const MomentsMap& m, const std::map<int,int>& model) {
+                       __int128 sum = 0, sumSq = 0;
+                       for (auto& e : model) {
+                         sum += e.second;
+                         sumSq += (__int128) e.second * e.second;
+                       }
+                       MomentsMap::Info s = m.stats();
+                       assert(s.num == model.size());
+                       assert(exactSum(s.sum, s.wraps) == sum);
+                       assert(exactSum(s.sumSq, s.sqWraps) == sumSq);
+                     });
+}
+
+// the nodes of every layer are plain structs, with no vtable pointer
+static_assert(!std::is_polymorphic<BSTMapNode<int, int> >::value, "BST nodes have a vtable");
+static_assert(!std::is_polymorphic<AVLTreeMapNode<int, int> >::value, "AVL nodes have a vtable");
+static_assert(!std::is_polymorphic<TreeMapStatsNode<int, int, StatsAggregate<int> > >::value, "stats nodes have a vtable");
+struct PlainAVLNode { int key; int value; void* left; void* right; void* parent; int ht; };
+static_assert(sizeof(AVLTreeMapNode<int, int>) == sizeof(PlainAVLNode), "AVL nodes hold more than their entry, links and height");
+
+// random updates of the plain BST and AVL layers, with values of type V
+template <class V>
+void testLayers(std::mt19937_64& rng) {
+  typedef BasicBSTMap<int, V> BST;
+  typedef BasicAVLTreeMap<int, V> AVL;
+  BST bst;
+  std::map<int,V> bstModel;
+  checkRandomUpdates(bst, bstModel, findValue<BST, V>, 5000, 500, rng, 500, [](const BST&, const std::map<int,V>&) { });
+  AVL avl;
+  std::map<int,V> avlModel;
+  checkRandomUpdates(avl, avlModel, findValue<AVL, V>, 20000, 2000, rng, 1000, [](const AVL&, const std::map<int,V>&) { });
+}
+
+// a map ordered by another comparator keeps its entries in that order
+static void testCompare() {
+  BasicTreeMapStats<int, int, StatsAggregate<int>, std::greater<int> > m;
+  for (int i = 0; i < 10; i++) m.put(i, i);
+  std::ostringstream os;
+  m.printMap(os);
+  assert(os.str().find("9:9") < os.str().find("0:0"));
+  m.erase(9);
+  assert(!m.find(9) && m.find(8) && m.stats().max == 8);
+}
+
+int main() {
+  std::mt19937_64 rng(3);
+  testStats<int>(rng);
+  testStats<unsigned>(rng);
+  testStats<uint64_t>(rng);
+  testAggregates(rng);
+  testLayers<int>(rng);
+  testLayers<uint64_t>(rng);
+  testCompare();
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/*
+# Purpose: Tests of bulk loading (BSTMap::bulkLoad and the bulk-load constructors) against std::map: unsorted
+# entries with repeated keys (the last value wins) and sorted ones, into empty and non-empty maps, give a tree
+# of minimum height with correct heights and stats, which later updates keep proper
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "TreeMapStatsCheck.h"
+
+// CheckedTreeMapStats bulk loaded from a vector of entries, with the height of its tree
+class LoadedTreeMapStats : public CheckedTreeMapStats {
+
+public:
+  LoadedTreeMapStats() { };
+  LoadedTreeMapStats(const vector<pair<int,int> >& e, bool sorted) { bulkLoad(e, sorted); };
+
+  // OUTPUT: the height of the tree (0 if empty)
+  int height() const { return root ? ((const Node*) root)->ht : 0; };
+  // OUTPUT: the stats of the whole map
+  // PRECONDITION: the map is not empty
+  const Node::Stats& stats() const { return ((const Node*) root)->getInfo(); };
+};
+
+// OUTPUT: the height of a tree of minimum height with n nodes
+static int minHeight(int n) {
+  int h = 0;
+  while (n > 0) {
+    n /= 2;
+    h++;
+  }
+  return h;
+}
+
+// POSTCONDITION: map m holds exactly the entries of model e
+static void checkEntries(const BSTMap& m, const map<int,int>& e) {
+  assert(m.size() == (int) e.size() && m.empty() == e.empty());
+  for (auto& x : e) {
+    BSTMap::Node* w = m.find(x.first);
+    assert(w && w->value == x.second);
+  }
+}
+
+// OUTPUT: n random entries with keys in [lo, lo + keys), in random order, keys repeating; the model e of the
+// map they load (the last value of each key)
+static vector<pair<int,int> > randomLoad(int n, int lo, int keys, map<int,int>& e, mt19937_64& rng) {
+  vector<pair<int,int> > v;
+  e.clear();
+  for (int i = 0; i < n; i++) {
+    int k = lo + (int) (rng() % keys);
+    int x = (int) rng();
+    v.push_back(make_pair(k, x));
+    e[k] = x;
+  }
+  return v;
+}
+
+// unsorted entries with repeated keys, through the constructor and into a map already holding entries
+static void testUnsorted(mt19937_64& rng) {
+  for (int n : {0, 1, 2, 3, 7, 8, 9, 100, 1023, 1024, 50000}) {
+    for (int keys : {1, 3, n / 2 + 1, 2 * n + 1}) {
+      map<int,int> e;
+      vector<pair<int,int> > v = randomLoad(n, -keys / 2, keys, e, rng);
+      LoadedTreeMapStats m(v, false);
+      assert(m.valid() && m.height() == minHeight((int) e.size()));
+      checkEntries(m, e);
+      // into the same map: the previous entries, with other keys, are all dropped
+      map<int,int> f;
+      v = randomLoad(n, INT_MAX - keys, keys, f, rng);
+      m.bulkLoad(v);
+      assert(m.valid() && m.height() == minHeight((int) f.size()));
+      checkEntries(m, f);
+      // the loaded tree takes updates as any other
+      for (int i = 0; i < n / 4; i++) {
+        int k = INT_MAX - (int) (rng() % (2 * keys + 2));
+        if (rng() % 2) {
+          m.put(k, i);
+          f[k] = i;
+        }
+        else {
+          m.erase(k);
+          f.erase(k);
+        }
+      }
+      assert(m.valid());
+      checkEntries(m, f);
+    }
+  }
+}
+
+// the same value for a key given again and again; and every entry of a key but the last overwritten
+static void testRepeatedKeys() {
+  vector<pair<int,int> > v;
+  for (int i = 0; i < 1000; i++) v.push_back(make_pair(i % 10, i));
+  LoadedTreeMapStats m(v, false);
+  map<int,int> e;
+  for (int k = 0; k < 10; k++) e[k] = 990 + k;
+  assert(m.valid() && m.height() == minHeight(10));
+  checkEntries(m, e);
+  const TreeMapStats::Node::Stats& s = m.stats();
+  assert(s.getNum() == 10 && s.getSum() == 9945 && s.getMin() == 990 && s.getMax() == 999);
+  v.assign(5000, make_pair(INT_MIN, INT_MIN));
+  v.push_back(make_pair(INT_MIN, INT_MAX));
+  m.bulkLoad(v);
+  assert(m.valid() && m.size() == 1 && m.find(INT_MIN)->value == INT_MAX);
+}
+
+// sorted entries (strictly increasing keys), in all the map classes
+static void testSorted(mt19937_64& rng) {
+  for (int n : {0, 1, 5, 64, 65, 30000}) {
+    map<int,int> e = randomEntries(n, 4 * n + 1, rng);
+    vector<pair<int,int> > v(e.begin(), e.end());
+    LoadedTreeMapStats m(v, true);
+    assert(m.valid() && m.height() == minHeight((int) e.size()));
+    checkEntries(m, e);
+    BSTMap b(v, true);
+    checkEntries(b, e);
+    AVLTreeMap a(v);
+    checkEntries(a, e);
+  }
+}
+
+int main() {
+  mt19937_64 rng(9);
+  testUnsorted(rng);
+  testRepeatedKeys();
+  testSorted(rng);
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
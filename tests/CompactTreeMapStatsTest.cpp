@@ -0,0 +1,39 @@
+/*
+# Purpose: Tests of CompactTreeMapStats: instantiated with int, unsigned and uint64_t values against a std::map,
+# and against BasicTreeMapStats, which it must build the same trees as
+*/
+
+#include <cstdint>
+
+#include "../BasicTreeMapStats.h"
+#include "../CompactTreeMapStats.h"
+#include "MapModelCheck.h"
+
+// the nodes of erased entries are reused, so churn at a steady size does not grow the node array
+static void testReuse() {
+  CompactTreeMapStats<int, int> m;
+  m.reserve(1000);
+  size_t bytes = m.memoryBytes();
+  for (int i = 0; i < 1000; i++) m.put(i, i);
+  for (int r = 0; r < 10; r++) {
+    for (int i = 0; i < 500; i++) m.erase((i * 7 + r) % 1000);
+    for (int i = 0; i < 1000; i++) m.put(i, -i);
+  }
+  assert(m.size() == 1000 && m.memoryBytes() == bytes);
+  assert(m.stats().num == 1000 && m.stats().min == -999 && m.stats().max == 0);
+  // with index links, no parent link and a 32-bit count, a node takes two thirds of a BasicTreeMapStats node
+  // with the same entry and aggregate, and half of one with a count only
+  assert(sizeof(CompactTreeMapStats<int, int>::Node) == 48 && sizeof(BasicTreeMapStats<int, int>::Node) == 72);
+  assert(sizeof(CompactTreeMapStats<int, int, CompactCountAggregate>::Node) == 24);
+  assert(sizeof(BasicTreeMapStats<int, int, CountAggregate>::Node) == 48);
+}
+
+int main() {
+  std::mt19937_64 rng(24);
+  checkAgainstBasic<CompactTreeMapStats<int, int>, BasicTreeMapStats<int, int>, int>(rng);
+  checkAgainstBasic<CompactTreeMapStats<int, unsigned>, BasicTreeMapStats<int, unsigned>, unsigned>(rng);
+  checkAgainstBasic<CompactTreeMapStats<int, uint64_t>, BasicTreeMapStats<int, uint64_t>, uint64_t>(rng);
+  testReuse();
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
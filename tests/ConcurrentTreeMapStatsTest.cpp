@@ -0,0 +1,76 @@
+/*
+# Purpose: Tests of ConcurrentTreeMapStats: instantiated with int, unsigned and uint64_t values against a
+# std::map, then with readers (held and temporary) running against a writer
+*/
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "../ConcurrentTreeMapStats.h"
+#include "MapModelCheck.h"
+
+// random updates and queries on one thread, with values of type V
+template <class V>
+void testModel(std::mt19937_64& rng) {
+  typedef ConcurrentTreeMapStats<int, V> Map;
+  Map m;
+  std::map<int,V> model;
+  checkRandomUpdates(m, model, [](const Map& m, int k, V* v) { return m.find(k, v); }, 20000, 2000, rng, 1000,
+                     [&rng](const Map& m, const std::map<int,V>& model) {
+                       checkRandomRanges(m, model, [](const Map& m, int lo, int hi) { return m.rangeStats(lo, hi); },
+                                         2000, rng);
+                       typename Map::Reader r(m);
+                       checkStats(model, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), r.stats());
+                     });
+  m.clear();
+  assert(m.empty() && m.stats().num == 0);
+}
+
+/*
+  # POSTCONDITION: readers query a map while a writer updates it; the keys in [-100, -1] are never updated, so
+  # every reader must always find them all; every other key k is either missing or mapped to 2k, in every
+  # version of the map
+*/
+static void testReadersAndWriter() {
+  typedef ConcurrentTreeMapStats<int, long long> Map;
+  Map m;
+  for (int k = -100; k < 0; k++) m.put(k, 2LL * k);
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&m, &done, t]() {
+      std::mt19937_64 rng(t);
+      Map::Reader held(m);
+      while (!done.load()) {
+        int k = (int) (rng() % 2000) - 100;
+        long long v;
+        bool found = (t % 2) ? held.find(k, &v) : m.find(k, &v);
+        assert(found ? v == 2LL * k : k >= 0);
+        Map::Info fixed = held.rangeStats(-100, -1);
+        assert(fixed.num == 100 && fixed.min == -200 && fixed.max == -2 && fixed.sum == -10100);
+        Map::Info s = m.rangeStats(k, k + 50);
+        assert(s.num <= 51 && (s.num == 0 || (s.min >= 2LL * k && s.max <= 2LL * (k + 50))));
+      }
+    });
+  }
+  std::mt19937_64 rng(19);
+  for (int i = 0; i < 200000; i++) {
+    int k = (int) (rng() % 1900);
+    if (rng() % 3 == 0) m.erase(k);
+    else m.put(k, 2LL * k);
+  }
+  done.store(true);
+  for (std::thread& r : readers) r.join();
+  assert(m.rangeStats(-100, -1).num == 100);
+}
+
+int main() {
+  std::mt19937_64 rng(19);
+  testModel<int>(rng);
+  testModel<unsigned>(rng);
+  testModel<uint64_t>(rng);
+  testReadersAndWriter();
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
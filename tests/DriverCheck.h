@@ -0,0 +1,56 @@
+/*
+# Purpose: Runs of the driver program of Main.cpp (./main, built by make test) on given commands, for the tests
+# of its commands; and the contents of files
+*/
+
+#ifndef DRIVER_CHECK_H
+#define DRIVER_CHECK_H
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+// OUTPUT: the contents of the file at path p
+inline std::string readFile(const std::string& p) {
+  std::string s;
+  FILE* f = fopen(p.c_str(), "rb");
+  assert(f);
+  char buf[4096];
+  size_t r;
+  while ((r = fread(buf, 1, sizeof(buf), f)) > 0) s.append(buf, r);
+  fclose(f);
+  return s;
+}
+
+// POSTCONDITION: the file at path p holds exactly s
+inline void writeFile(const std::string& p, const std::string& s) {
+  FILE* f = fopen(p.c_str(), "wb");
+  assert(f && fwrite(s.data(), 1, s.size(), f) == s.size());
+  fclose(f);
+}
+
+/*
+  # INPUT: the commands of an input file, one per line
+  # OUTPUT: the output of the driver program (./main, relative to the current directory) run on them, as its
+  # input.txt, in a new directory under /tmp (removed afterwards)
+*/
+inline std::string driverOutput(const std::string& commands) {
+  char dir[] = "/tmp/driver-XXXXXX";
+  assert(mkdtemp(dir));
+  std::string input = std::string(dir) + "/input.txt", output = std::string(dir) + "/output.txt";
+  writeFile(input, commands);
+  char* driver = realpath("main", NULL);
+  assert(driver);
+  std::string cmd = std::string("cd '") + dir + "' && '" + driver + "' > output.txt";
+  free(driver);
+  assert(system(cmd.c_str()) == 0);
+  std::string s = readFile(output);
+  remove(input.c_str());
+  remove(output.c_str());
+  rmdir(dir);
+  return s;
+}
+
+#endif // DRIVER_CHECK_H
@@ -0,0 +1,120 @@
+/*
+# Purpose: Tests of eraseRange of TreeMapStats against std::map: small windows (erased key by key) and large ones
+# (cut out of the tree), windows covering the whole map, and empty or reversed ones; the erased nodes go back to
+# the node pool of the map, and are the first to be reused
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "TreeMapStatsCheck.h"
+#include <set>
+
+// CheckedTreeMapStats that keeps track of the nodes it allocates and frees
+class TrackedTreeMapStats : public CheckedTreeMapStats {
+
+public:
+  // the nodes allocated and not yet freed; the nodes freed and not reused since
+  set<const BSTMap::Node*> live;
+  set<const BSTMap::Node*> freed;
+
+protected:
+  Node* createNode(int k, int v, BSTMap::Node* l, BSTMap::Node* r, BSTMap::Node* p) override {
+    Node* w = TreeMapStats::createNode(k, v, l, r, p);
+    live.insert(w);
+    freed.erase(w);
+    return w;
+  };
+  void destroyNode(BSTMap::Node* w) override {
+    assert(live.erase(w) == 1);
+    freed.insert(w);
+    TreeMapStats::destroyNode(w);
+  };
+};
+
+/*
+  # INPUT: a map m and its model e; a window [lo, hi]; a random generator
+  # POSTCONDITION: the window is erased from both, and m is checked against e: as many nodes as entries erased
+  # have been freed, and the nodes left hold the entries left (an erase may move an entry into the node of an
+  # erased one); new entries, as many as erased, are then put into both, each into one of the nodes freed
+*/
+static void checkEraseRange(TrackedTreeMapStats& m, map<int,int>& e, int lo, int hi, mt19937_64& rng) {
+  size_t expected = (lo > hi) ? 0 : distance(e.lower_bound(lo), e.upper_bound(hi));
+  set<const BSTMap::Node*> before = m.live;
+  m.freed.clear();
+  int count = m.eraseRange(lo, hi);
+  if (lo <= hi) e.erase(e.lower_bound(lo), e.upper_bound(hi));
+  assert(count == (int) expected);
+  assert(m.valid() && entries(m) == e);
+  assert(m.freed.size() == expected && m.live.size() == e.size());
+  for (auto& x : e) assert(m.live.count(m.find(x.first)));
+  for (const BSTMap::Node* w : m.freed) assert(before.count(w));
+  // the freed nodes are reused first
+  set<const BSTMap::Node*> freed = m.freed;
+  for (int i = 0; i < count; ) {
+    int k = (int) (rng() % 1000000) - 500000;
+    if (e.count(k)) continue;
+    m.put(k, i);
+    e[k] = i++;
+    assert(freed.count(m.find(k)));
+  }
+  assert(m.freed.empty() && m.valid() && entries(m) == e);
+}
+
+// POSTCONDITION: map m and its model e hold n random entries (new ones are added to those already there)
+static void fill(TrackedTreeMapStats& m, map<int,int>& e, int n, mt19937_64& rng) {
+  while ((int) e.size() < n) {
+    int k = (int) (rng() % 1000000) - 500000;
+    m.put(k, (int) rng());
+    e[k] = m.find(k)->value;
+  }
+}
+
+// windows of every size, around and beyond SMALL_RANGE entries, at random places in maps of several sizes
+static void testRandomWindows(mt19937_64& rng) {
+  for (int n : {1, 20, 1000, 20000}) {
+    TrackedTreeMapStats m;
+    map<int,int> e;
+    fill(m, e, n, rng);
+    for (int width : {0, 1, 15, 16, 17, 18, 40, 500, 5000}) {
+      if (width >= n) continue;
+      for (int j = 0; j < 5; j++) {
+        // a window from a key in the map, or from a key between keys, of about width entries
+        map<int,int>::iterator i = e.begin();
+        advance(i, rng() % (e.size() - width));
+        int lo = i->first - (int) (rng() % 2);
+        advance(i, width);
+        int hi = i->first - (int) (rng() % 2);
+        checkEraseRange(m, e, lo, hi, rng);
+      }
+    }
+  }
+}
+
+// windows that cover the whole map, or nothing in it
+static void testWholeAndEmptyWindows(mt19937_64& rng) {
+  for (int n : {0, 1, 16, 17, 3000}) {
+    TrackedTreeMapStats m;
+    map<int,int> e;
+    fill(m, e, n, rng);
+    // reversed, and beyond the keys on either side
+    checkEraseRange(m, e, 10, 9, rng);
+    checkEraseRange(m, e, INT_MAX, INT_MIN, rng);
+    checkEraseRange(m, e, INT_MIN, -500001, rng);
+    checkEraseRange(m, e, 500000, INT_MAX, rng);
+    // exactly from the smallest to the largest key, then everything
+    if (n) checkEraseRange(m, e, e.begin()->first, e.rbegin()->first, rng);
+    fill(m, e, n, rng);
+    checkEraseRange(m, e, INT_MIN, INT_MAX, rng);
+    m.eraseRange(INT_MIN, INT_MAX);
+    assert(m.empty() && m.live.empty() && m.valid());
+    assert(m.eraseRange(0, 0) == 0 && m.eraseRange(INT_MIN, INT_MAX) == 0);
+  }
+}
+
+int main() {
+  mt19937_64 rng(17);
+  testRandomWindows(rng);
+  testWholeAndEmptyWindows(rng);
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
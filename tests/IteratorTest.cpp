@@ -0,0 +1,145 @@
+/*
+# Purpose: Tests of ordered iteration over the maps of Main.cpp: the iterators (forward, backward, and back from
+# end()), lower_bound, upper_bound and equal_range, and successor and predecessor, against std::map, for plain
+# BSTs (balanced or not) and AVL trees
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "TreeMapStatsCheck.h"
+
+// OUTPUT: the key of the node of iterator i of map m, or def at end()
+static int keyOr(const BSTMap& m, BSTMap::iterator i, int def) {
+  return i == m.end() ? def : i->key;
+}
+
+// OUTPUT: the key of the entry of iterator i of model e, or def at its end()
+static int keyOr(const map<int,int>& e, map<int,int>::const_iterator i, int def) {
+  return i == e.end() ? def : i->first;
+}
+
+// POSTCONDITION: the entries of map m are those of the model e, whichever way they are iterated
+static void checkIteration(const BSTMap& m, const map<int,int>& e) {
+  // forward, with pre- and post-increment
+  map<int,int>::const_iterator j = e.begin();
+  for (BSTMap::iterator i = m.begin(); i != m.end(); i++, ++j) {
+    assert(j != e.end() && i->key == j->first && (*i).value == j->second);
+  }
+  assert(j == e.end());
+  assert(distance(m.begin(), m.end()) == (ptrdiff_t) e.size());
+  // backward from end(), with pre- and post-decrement
+  map<int,int>::const_reverse_iterator r = e.rbegin();
+  BSTMap::iterator i = m.end();
+  while (i != m.begin()) {
+    if (r == e.rbegin()) --i;
+    else i--;
+    assert(r != e.rend() && i->key == r->first && i->value == r->second);
+    ++r;
+  }
+  assert(r == e.rend());
+  if (e.empty()) assert(m.begin() == m.end());
+  else {
+    assert((--m.end())->key == e.rbegin()->first && m.begin()->key == e.begin()->first);
+    // a round trip
+    BSTMap::iterator b = m.begin();
+    assert(--(++b) == m.begin());
+  }
+}
+
+// POSTCONDITION: lower_bound, upper_bound and equal_range of map m agree with those of model e for key k
+static void checkBounds(const BSTMap& m, const map<int,int>& e, int k) {
+  assert(keyOr(m, m.lower_bound(k), INT_MIN) == keyOr(e, e.lower_bound(k), INT_MIN));
+  assert(keyOr(m, m.upper_bound(k), INT_MIN) == keyOr(e, e.upper_bound(k), INT_MIN));
+  pair<BSTMap::iterator,BSTMap::iterator> r = m.equal_range(k);
+  auto s = e.equal_range(k);
+  assert(keyOr(m, r.first, INT_MIN) == keyOr(e, s.first, INT_MIN));
+  assert(keyOr(m, r.second, INT_MIN) == keyOr(e, s.second, INT_MIN));
+  assert(distance(r.first, r.second) == distance(s.first, s.second));
+}
+
+// POSTCONDITION: the successor and predecessor of every node of map m are those of its key in model e
+static void checkNeighbors(const BSTMap& m, const map<int,int>& e) {
+  for (map<int,int>::const_iterator j = e.begin(); j != e.end(); ++j) {
+    BSTMap::Node* w = m.find(j->first);
+    assert(w);
+    BSTMap::Node* s = m.successor(w);
+    BSTMap::Node* p = m.predecessor(w);
+    map<int,int>::const_iterator next = j;
+    ++next;
+    if (next == e.end()) assert(!s);
+    else assert(s && s->key == next->first);
+    if (j == e.begin()) assert(!p);
+    else assert(p && p->key == prev(j)->first);
+  }
+  assert(!m.successor(NULL) && !m.predecessor(NULL));
+}
+
+// POSTCONDITION: all of the above hold for map m and model e, for every key in the map and around it
+static void checkAll(const BSTMap& m, const map<int,int>& e) {
+  checkIteration(m, e);
+  checkNeighbors(m, e);
+  for (auto& x : e) {
+    checkBounds(m, e, x.first);
+    checkBounds(m, e, x.first - 1);
+    checkBounds(m, e, x.first + 1);
+  }
+  checkBounds(m, e, INT_MIN);
+  checkBounds(m, e, INT_MAX);
+}
+
+// maps of several sizes built by puts (random, increasing and decreasing keys), then thinned out by erases
+template <class Map>
+static void testMap(mt19937_64& rng) {
+  for (int n : {0, 1, 2, 3, 10, 1000}) {
+    for (int order = 0; order < 3; order++) {
+      Map m;
+      map<int,int> e;
+      for (int i = 0; i < n; i++) {
+        int k = (order == 0) ? (int) (rng() % (4 * n)) - 2 * n : (order == 1) ? 3 * i : -3 * i;
+        m.put(k, i);
+        e[k] = i;
+      }
+      checkAll(m, e);
+      for (int i = 0; i < n / 2; i++) {
+        int k = (int) (rng() % (4 * n + 1)) - 2 * n;
+        m.erase(k);
+        e.erase(k);
+      }
+      checkAll(m, e);
+    }
+  }
+}
+
+// the smallest trees on which each way up to the successor or predecessor is taken
+static void testSmallTrees() {
+  // 2 at the root, 1 its left child: the successor of 1 is its parent, reached going up from a left child
+  BSTMap m;
+  m.put(2, 20);
+  m.put(1, 10);
+  assert(m.successor(m.find(1)) == m.find(2) && !m.successor(m.find(2)));
+  assert(m.predecessor(m.find(2)) == m.find(1) && !m.predecessor(m.find(1)));
+  // 1 at the root, 2 its right child
+  BSTMap r;
+  r.put(1, 10);
+  r.put(2, 20);
+  assert(r.successor(r.find(1)) == r.find(2) && !r.successor(r.find(2)));
+  assert(r.predecessor(r.find(2)) == r.find(1) && !r.predecessor(r.find(1)));
+  // 3 at the root, 1 its left child, 2 the right child of 1: up past a right child to 3
+  BSTMap z;
+  z.put(3, 30);
+  z.put(1, 10);
+  z.put(2, 20);
+  assert(z.successor(z.find(2)) == z.find(3) && z.predecessor(z.find(3)) == z.find(2));
+  assert(z.successor(z.find(1)) == z.find(2) && z.predecessor(z.find(2)) == z.find(1));
+  checkAll(z, map<int,int>{{1, 10}, {2, 20}, {3, 30}});
+}
+
+int main() {
+  mt19937_64 rng(13);
+  testSmallTrees();
+  testMap<BSTMap>(rng);
+  testMap<AVLTreeMap>(rng);
+  testMap<CheckedTreeMapStats>(rng);
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+/*
+# Purpose: Tests of split and join of AVLTreeMap and TreeMapStats: a split partitions the entries at its key,
+# a join concatenates them, and both leave proper AVL trees with correct stats
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "TreeMapStatsCheck.h"
+
+// OUTPUT: the entries of e with keys in [lo, hi)
+static map<int,int> slice(const map<int,int>& e, long long lo, long long hi) {
+  map<int,int> s;
+  for (auto& x : e)
+    if (x.first >= lo && x.first < hi) s.insert(x);
+  return s;
+}
+
+// splits at keys below, inside (present or not) and above the keys of the map, then joins the parts back
+static void testSplitJoin(mt19937_64& rng) {
+  for (int n : {0, 1, 2, 10, 1000, 20000}) {
+    map<int,int> e = randomEntries(n, 2 * n + 1, rng);
+    for (int k : {-5, 0, n / 3, n, 2 * n, 2 * n + 1, 3 * n + 10}) {
+      CheckedTreeMapStats m(e), right;
+      right.put(-100, 1);
+      assert(m.split(k, right));
+      assert(m.valid() && right.valid());
+      assert(entries(m) == slice(e, INT_MIN, k));
+      assert(entries(right) == slice(e, k, INT_MAX + 1LL));
+      TreeMapStats::Node::Stats s = right.rangeStats(INT_MIN, INT_MAX);
+      assert(s.getNum() == right.size());
+      assert(m.join(right));
+      assert(m.valid() && right.valid() && right.empty());
+      assert(entries(m) == e);
+      // the parts stay usable after the move: the nodes now share one pool
+      m.put(k, k);
+      m.erase(n / 2);
+      assert(m.valid());
+    }
+  }
+}
+
+// joins of maps of very different heights, built separately (so in separate node pools)
+static void testJoinHeights(mt19937_64& rng) {
+  for (int n : {1, 5, 100, 5000}) {
+    map<int,int> a = randomEntries(n, 4 * n, rng);
+    map<int,int> b;
+    for (auto& x : randomEntries(30000 / n, 1 << 20, rng)) b[x.first + 4 * n] = x.second;
+    map<int,int> all(a);
+    all.insert(b.begin(), b.end());
+    CheckedTreeMapStats l(a), r(b);
+    assert(l.join(r));
+    assert(l.valid() && entries(l) == all);
+    CheckedTreeMapStats l2(a), r2(b);
+    assert(r2.join(l2) == false);
+    assert(entries(r2) == b && entries(l2) == a);
+  }
+}
+
+// the maps are left unchanged by the operations that are refused
+static void testRefused() {
+  CheckedTreeMapStats m(map<int,int>{{1, 1}, {2, 2}, {3, 3}}), other(map<int,int>{{3, 3}, {4, 4}});
+  assert(!m.split(2, m));
+  assert(!m.join(m));
+  assert(!m.join(other));
+  assert(m.size() == 3 && other.size() == 2 && m.valid() && other.valid());
+  TreeMapStats plain;
+  assert(!m.split(2, plain) && !m.join(plain));
+  assert(m.size() == 3 && plain.empty());
+}
+
+// AVLTreeMap (with no stats, so the moved entries are counted by a traversal)
+static void testAVLTreeMap(mt19937_64& rng) {
+  map<int,int> e = randomEntries(5000, 10000, rng);
+  AVLTreeMap m(vector<pair<int,int> >(e.begin(), e.end()), true), right;
+  assert(m.split(5000, right));
+  assert(entries(m) == slice(e, INT_MIN, 5000) && entries(right) == slice(e, 5000, INT_MAX + 1LL));
+  assert(m.size() + right.size() == (int) e.size());
+  assert(m.join(right));
+  assert(entries(m) == e && right.empty() && m.size() == (int) e.size());
+}
+
+int main() {
+  mt19937_64 rng(15);
+  testSplitJoin(rng);
+  testJoinHeights(rng);
+  testRefused();
+  testAVLTreeMap(rng);
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
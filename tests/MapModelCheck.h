@@ -0,0 +1,132 @@
+/*
+# Purpose: Shared checks of the tests of the header-only maps: random updates are applied both to a map and to a
+# std::map (the model), and the lookups and aggregates of the map are compared with those of the model
+*/
+
+#ifndef MAP_MODEL_CHECK_H
+#define MAP_MODEL_CHECK_H
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+
+// OUTPUT: the exact sum that an aggregate with sum s and wrap count wraps stands for (see wrappingAdd)
+template <class S>
+__int128 exactSum(S s, long long wraps) {
+  return (__int128) s + (__int128) wraps * ((__int128) 1 << 64);
+}
+
+/*
+  # INPUT: a model of a map; keys lo and hi; the StatsAggregate of the entries of the map with keys in [lo, hi]
+  # POSTCONDITION: the aggregate matches the entries of the model with keys in [lo, hi] (or the program aborts)
+*/
+template <class V, class Info>
+void checkStats(const std::map<int,V>& model, int lo, int hi, const Info& s) {
+  size_t num = 0;
+  __int128 sum = 0;
+  V mn = std::numeric_limits<V>::max();
+  V mx = std::numeric_limits<V>::lowest();
+  for (typename std::map<int,V>::const_iterator i = model.lower_bound(lo); i != model.end() && i->first <= hi; ++i) {
+    num++;
+    sum += i->second;
+    mn = std::min(mn, i->second);
+    mx = std::max(mx, i->second);
+  }
+  assert(s.num == num);
+  assert(exactSum(s.sum, s.wraps) == sum);
+  if (num > 0) {
+    assert(s.min == mn);
+    assert(s.max == mx);
+  }
+}
+
+/*
+  # INPUT: a map m and an empty model; a function find(m, k, v) that returns true iff key k is in m, and then
+  # stores its value in *v; a number of updates, ops, on keys in [0, keys); a random generator; a function
+  # check(m, model), called every checkEvery updates and at the end
+  # POSTCONDITION: ops random puts (of values over the whole range of V) and erases are applied to m and to
+  # the model; after each, m and the model agree on the key updated
+*/
+template <class Map, class V, class Find, class Check>
+void checkRandomUpdates(Map& m, std::map<int,V>& model, Find find, int ops, int keys, std::mt19937_64& rng,
+                        int checkEvery, Check check) {
+  std::uniform_int_distribution<int> key(0, keys - 1);
+  std::uniform_int_distribution<V> value(std::numeric_limits<V>::lowest(), std::numeric_limits<V>::max());
+  for (int i = 0; i < ops; i++) {
+    int k = key(rng);
+    if (rng() % 3 == 0) {
+      m.erase(k);
+      model.erase(k);
+    }
+    else {
+      V v = value(rng);
+      m.put(k, v);
+      model[k] = v;
+    }
+    V v = V();
+    bool found = find(m, k, &v);
+    assert(found == (model.count(k) == 1));
+    assert(!found || v == model[k]);
+    assert((size_t) m.size() == model.size());
+    if ((i + 1) % checkEvery == 0) check(m, model);
+  }
+  check(m, model);
+}
+
+/*
+  # INPUT: a map m and its model; a function range(m, lo, hi) that returns the aggregate of the entries of m with
+  # keys in [lo, hi]; the bound, keys, of the keys; a random generator
+  # POSTCONDITION: the aggregates of some random ranges (and of the whole map) match the model
+*/
+template <class Map, class V, class Range>
+void checkRandomRanges(const Map& m, const std::map<int,V>& model, Range range, int keys, std::mt19937_64& rng) {
+  std::uniform_int_distribution<int> key(-1, keys);
+  checkStats(model, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(),
+             range(m, std::numeric_limits<int>::min(), std::numeric_limits<int>::max()));
+  for (int i = 0; i < 20; i++) {
+    int lo = key(rng), hi = key(rng);
+    checkStats(model, lo, hi, range(m, lo, hi));
+  }
+}
+
+// OUTPUT: the parenthetic string of the entries of map m, which shows the shape of its tree
+template <class Map>
+std::string shape(const Map& m) {
+  std::ostringstream os;
+  m.printMap(os);
+  return os.str();
+}
+
+/*
+  # INPUT: a random generator
+  # POSTCONDITION: random updates of a Map, whose find returns its node with the key (or NULL), are checked
+  # against a std::map, with values of type V; the same updates replayed on a Basic map (the reference
+  # implementation, BasicTreeMapStats) give a tree of the same shape at every check; the Map is then cleared
+*/
+template <class Map, class Basic, class V>
+void checkAgainstBasic(std::mt19937_64& rng) {
+  Map m;
+  std::map<int,V> model;
+  Basic basic;
+  checkRandomUpdates(m, model, [&basic](Map& m, int k, V* v) {
+                       // replay the update of k on the basic map
+                       const typename Map::Node* w = m.find(k);
+                       if (w) basic.put(k, *v = w->value);
+                       else basic.erase(k);
+                       return w != NULL;
+                     }, 20000, 2000, rng, 1000,
+                     [&rng, &basic](const Map& m, const std::map<int,V>& model) {
+                       checkRandomRanges(m, model, [](const Map& m, int lo, int hi) { return m.rangeStats(lo, hi); },
+                                         2000, rng);
+                       assert(shape(m) == shape(basic));
+                     });
+  m.clear();
+  assert(m.empty() && m.stats().num == 0);
+}
+
+#endif // MAP_MODEL_CHECK_H
@@ -0,0 +1,95 @@
+/*
+# Purpose: Tests of the memory-mapped images of TreeMapStats (TreeMapStats::saveImage, MappedTreeMapStats):
+# every query on an image gives the same answer as on the map it was saved from, and invalid images are rejected
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "TreeMapStatsCheck.h"
+
+// path of the image file of the tests
+static string path;
+
+// OUTPUT: true iff stats s and t are equal
+static bool sameStats(const TreeMapStats::Node::Stats& s, const TreeMapStats::Node::Stats& t) {
+  return s.getNum() == t.getNum() && s.getSum() == t.getSum() &&
+    (s.getNum() == 0 || (s.getMin() == t.getMin() && s.getMax() == t.getMax()));
+}
+
+// the queries of maps of several sizes give the same answers on their images
+static void testQueries(mt19937_64& rng) {
+  for (int n : {0, 1, 2, 5, 1000, 100000}) {
+    map<int,int> e = randomEntries(n, 4 * n + 1, rng);
+    CheckedTreeMapStats m(e);
+    for (int i = 0; i < n / 10; i++) m.erase((int) (rng() % (4 * n + 1)));
+    assert(m.saveImage(path));
+    MappedTreeMapStats image;
+    assert(image.open(path));
+    assert(image.isOpen() && image.size() == m.size() && image.empty() == m.empty());
+    assert(sameStats(image.stats(), m.rangeStats(INT_MIN, INT_MAX)));
+    uniform_int_distribution<int> key(-2, 4 * n + 2);
+    for (int i = 0; i < 2000; i++) {
+      int k = key(rng), k2 = key(rng);
+      const MappedTreeMapStats::Node* w = image.find(k);
+      BSTMap::Node* x = m.find(k);
+      assert((w == NULL) == (x == NULL) && (!w || (w->key == x->key && w->value == x->value)));
+      assert(image.rank(k) == m.rank(k));
+      const MappedTreeMapStats::Node* s = image.select(k);
+      TreeMapStats::Node* t = m.select(k);
+      assert((s == NULL) == (t == NULL) && (!s || s->key == t->key));
+      assert(sameStats(image.rangeStats(k, k2), m.rangeStats(k, k2)));
+    }
+    // the image stays valid after the map is updated
+    map<int,int> saved = entries(m);
+    m.clear();
+    assert(image.size() == (int) saved.size());
+    for (auto& x : saved) assert(image.find(x.first) && image.find(x.first)->value == x.second);
+    image.close();
+    assert(!image.isOpen() && image.empty());
+  }
+}
+
+// invalid images are rejected, and the image opened before stays open
+static void testInvalid() {
+  CheckedTreeMapStats m(map<int,int>{{1, 10}, {2, 20}, {3, 30}});
+  assert(m.saveImage(path));
+  MappedTreeMapStats image;
+  assert(image.open(path));
+  string bad = path + ".bad";
+  FILE* f = fopen(path.c_str(), "rb");
+  string s(4096, '\0');
+  s.resize(fread(&s[0], 1, s.size(), f));
+  fclose(f);
+  vector<string> damaged;
+  damaged.push_back(s.substr(0, s.size() - 1));
+  damaged.push_back(s + 'x');
+  damaged.push_back(s.substr(0, sizeof(MappedTreeMapStats::Header) - 1));
+  for (size_t i : {offsetof(MappedTreeMapStats::Header, magic), offsetof(MappedTreeMapStats::Header, byteOrder),
+                   offsetof(MappedTreeMapStats::Header, nodeBytes), offsetof(MappedTreeMapStats::Header, count)}) {
+    string d = s;
+    d[i] ^= 1;
+    damaged.push_back(d);
+  }
+  for (size_t i = 0; i < damaged.size(); i++) {
+    f = fopen(bad.c_str(), "wb");
+    assert(fwrite(damaged[i].data(), 1, damaged[i].size(), f) == damaged[i].size());
+    fclose(f);
+    assert(!image.open(bad));
+    assert(image.isOpen() && image.size() == 3 && image.find(2)->value == 20);
+  }
+  assert(!image.open(path + ".missing"));
+  remove(bad.c_str());
+}
+
+int main() {
+  char tmpl[] = "/tmp/image-test-XXXXXX";
+  assert(mkdtemp(tmpl));
+  path = string(tmpl) + "/image";
+  mt19937_64 rng(22);
+  testQueries(rng);
+  testInvalid();
+  remove(path.c_str());
+  rmdir(tmpl);
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+/*
+# Purpose: Tests of the order statistics of TreeMapStats (select, rank and median) against a sorted vector of
+# the keys, for maps of even and odd sizes, as they grow and shrink
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "TreeMapStatsCheck.h"
+
+// POSTCONDITION: select, rank and median of map m agree with the sorted keys of its entries, model e
+static void checkOrder(const TreeMapStats& m, const map<int,int>& e) {
+  vector<int> keys;
+  for (auto& x : e) keys.push_back(x.first);
+  int n = (int) keys.size();
+  assert(m.size() == n);
+  // select of every rank, and of ranks out of range
+  for (int i = 0; i < n; i++) {
+    TreeMapStats::Node* w = m.select(i);
+    assert(w && w->key == keys[i] && w->value == e.at(keys[i]));
+  }
+  int outside[] = { -1, -2, n, n + 1, INT_MIN, INT_MAX };
+  for (int i : outside) assert(!m.select(i));
+  // rank of every key, of the keys beside them (absent unless adjacent), and of the extreme keys
+  for (int i = 0; i < n; i++) {
+    assert(m.rank(keys[i]) == i);
+    assert(m.rank(keys[i] + 1) == (int) (upper_bound(keys.begin(), keys.end(), keys[i]) - keys.begin()));
+    assert(m.rank(keys[i] - 1) == (int) (lower_bound(keys.begin(), keys.end(), keys[i] - 1) - keys.begin()));
+    assert(m.select(m.rank(keys[i]))->key == keys[i]);
+  }
+  assert(m.rank(INT_MIN) == 0);
+  assert(m.rank(INT_MAX) == (int) (lower_bound(keys.begin(), keys.end(), INT_MAX) - keys.begin()));
+  // median: the lower one of the two middle keys for an even size
+  TreeMapStats::Node* w = m.median();
+  if (n == 0) assert(!w);
+  else assert(w && w->key == keys[(n - 1) / 2]);
+}
+
+// small maps of every size, odd and even, including the empty map
+static void testSmall() {
+  CheckedTreeMapStats m;
+  map<int,int> e;
+  checkOrder(m, e);
+  assert(m.rank(0) == 0 && !m.median() && !m.select(0));
+  for (int i = 0; i < 20; i++) {
+    int k = (i % 2) ? 10 * i : -10 * i;
+    m.put(k, i);
+    e[k] = i;
+    checkOrder(m, e);
+  }
+  // 2 entries: the median is the smaller one; 3 entries: the middle one
+  CheckedTreeMapStats two;
+  two.put(8, 80);
+  two.put(4, 40);
+  assert(two.median()->key == 4);
+  two.put(6, 60);
+  assert(two.median()->key == 6);
+  two.erase(4);
+  assert(two.median()->key == 6 && two.select(1)->key == 8 && two.rank(7) == 1);
+}
+
+// large random maps, through puts and erases, checked at sizes of both parities
+static void testRandom(mt19937_64& rng) {
+  for (int n : {101, 1000, 20000}) {
+    map<int,int> e = randomEntries(n, 3 * n, rng);
+    CheckedTreeMapStats m;
+    for (auto& x : e) m.put(x.first, x.second);
+    checkOrder(m, e);
+    for (int round = 0; round < 4; round++) {
+      for (int i = 0; i < n / 3 + round; i++) {
+        int k = (int) (rng() % (3 * n));
+        if (rng() % 2) {
+          m.put(k, i);
+          e[k] = i;
+        }
+        else {
+          m.erase(k);
+          e.erase(k);
+        }
+      }
+      assert(m.valid());
+      checkOrder(m, e);
+    }
+    // shrink to empty
+    while (!e.empty()) {
+      int k = e.begin()->first;
+      if (rng() % 2) k = e.rbegin()->first;
+      m.erase(k);
+      e.erase(k);
+      if (e.size() % 997 < 2) checkOrder(m, e);
+    }
+    checkOrder(m, e);
+  }
+}
+
+int main() {
+  mt19937_64 rng(6);
+  testSmall();
+  testRandom(rng);
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
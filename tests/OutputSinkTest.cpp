@@ -0,0 +1,141 @@
+/*
+# Purpose: Tests of OutputSink: integers and strings come out exactly as formatted by the standard library, in
+# order, and the output reaches the file when the buffer fills up, on flush, and when the sink is destroyed,
+# but not before
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "DriverCheck.h"
+#include <climits>
+#include <random>
+
+// size of the buffer of an OutputSink
+static const size_t BUFFER = 1 << 20;
+
+// path of the output file of the tests
+static string path;
+
+// integers of all signs and sizes, alone and between other output
+static void testIntegers() {
+  FILE* f = fopen(path.c_str(), "wb");
+  assert(f);
+  string expected;
+  {
+    OutputSink out(f);
+    int ints[] = { 0, -0, 1, -1, 9, 10, -10, 99, 100, 123456789, -123456789, INT_MAX, INT_MIN, INT_MIN + 1 };
+    for (int v : ints) {
+      out << v << ' ';
+      expected += to_string(v) + ' ';
+    }
+    long long longs[] = { 0, -1, (long long) INT_MAX + 1, (long long) INT_MIN - 1, LLONG_MAX, LLONG_MIN };
+    for (long long v : longs) {
+      out << v << '|';
+      expected += to_string(v) + '|';
+    }
+    out << "text" << string_view("view") << 'c' << -5 << "\n";
+    expected += "textviewc-5\n";
+  }
+  fclose(f);
+  assert(readFile(path) == expected);
+}
+
+// OUTPUT: the number of bytes handed to file f so far (written out, or held in its stdio buffer)
+static long handed(FILE* f) {
+  return ftell(f);
+}
+
+// nothing reaches the file until the buffer is full; a full buffer is handed over whole
+static void testOverflow() {
+  FILE* f = fopen(path.c_str(), "wb");
+  assert(f);
+  string expected;
+  {
+    OutputSink out(f);
+    string chunk(1000, 'x');
+    while (expected.size() + chunk.size() <= BUFFER) {
+      out << string_view(chunk);
+      expected += chunk;
+    }
+    out << 'y';
+    expected += 'y';
+    assert(handed(f) == 0);
+    // the next string does not fit: the buffer is handed over first
+    out << string_view(chunk);
+    assert(handed(f) == (long) expected.size());
+    expected += chunk;
+    // single characters and integers fill the buffer up in the same way
+    while (expected.size() - handed(f) < BUFFER) {
+      out << 'z';
+      expected += 'z';
+    }
+    long before = handed(f);
+    out << 'z';
+    expected += 'z';
+    assert(handed(f) == before + (long) BUFFER);
+    mt19937_64 rng(11);
+    for (int i = 0; i < 500000; i++) {
+      int v = (int) rng();
+      out << v << ',';
+      expected += to_string(v) + ',';
+    }
+    assert(handed(f) > (long) BUFFER && expected.size() - handed(f) <= BUFFER);
+  }
+  // the rest was written by the destructor
+  assert(handed(f) == (long) expected.size());
+  fclose(f);
+  assert(readFile(path) == expected);
+}
+
+// strings as long as the buffer, or longer, are written out directly, after what was already buffered
+static void testLongStrings() {
+  FILE* f = fopen(path.c_str(), "wb");
+  assert(f);
+  {
+    OutputSink out(f);
+    string expected;
+    size_t lengths[] = { 10, BUFFER - 1, BUFFER, 3, BUFFER + 1, 3 * BUFFER, 0, 2 };
+    char c = 'a';
+    for (size_t m : lengths) {
+      string s(m, c++);
+      out << string_view(s);
+      expected += s;
+    }
+    out.flush();
+    assert(readFile(path) == expected);
+  }
+  fclose(f);
+}
+
+// flush hands the buffer to the file and flushes the file, so the output can be read back at once
+static void testFlush() {
+  FILE* f = fopen(path.c_str(), "wb");
+  assert(f);
+  {
+    OutputSink out(f);
+    out << "first " << 1 << '\n';
+    assert(handed(f) == 0 && readFile(path).empty());
+    out.flush();
+    assert(readFile(path) == "first 1\n");
+    out.flush();
+    out << "second " << INT_MIN << '\n';
+    assert(readFile(path) == "first 1\n");
+    out.flush();
+    assert(readFile(path) == "first 1\nsecond -2147483648\n");
+  }
+  fclose(f);
+}
+
+int main() {
+  char dir[] = "/tmp/output-XXXXXX";
+  assert(mkdtemp(dir));
+  path = string(dir) + "/output.txt";
+  testIntegers();
+  testOverflow();
+  testLongStrings();
+  testFlush();
+  remove(path.c_str());
+  rmdir(dir);
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,160 @@
+/*
+# Purpose: Tests of the input of the driver program: CommandReader hands out every line of a file, however long
+# and wherever it falls in the read buffer; nextToken, nextInt and parseCommand accept exactly the well-formed
+# tokens; and the driver ignores commands with missing or malformed arguments
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "DriverCheck.h"
+#include <climits>
+#include <random>
+
+// OUTPUT: the lines of the file at path p, as read by a CommandReader
+static vector<string> readLines(const string& p) {
+  CommandReader input(p);
+  vector<string> lines;
+  string_view line;
+  while (input.nextLine(line)) lines.push_back(string(line));
+  return lines;
+}
+
+// lines of all lengths, up to several times the buffer, crossing its end, and a last line with no end of line
+static void testCommandReader() {
+  char dir[] = "/tmp/parser-XXXXXX";
+  assert(mkdtemp(dir));
+  string p = string(dir) + "/input.txt";
+  mt19937_64 rng(10);
+  vector<string> lines;
+  string contents;
+  size_t lengths[] = { 0, 1, 0, 1000, (1 << 20) - 1, 1 << 20, (1 << 20) + 1, 3 << 20, 7, 0 };
+  for (size_t m : lengths) {
+    string line(m, 'a');
+    for (char& c : line) c = (char) ('a' + rng() % 26);
+    lines.push_back(line);
+    contents += line + '\n';
+  }
+  // short lines, so that lines straddle the ends of the chunks read
+  for (int i = 0; i < 300000; i++) {
+    lines.push_back(to_string(rng() % 1000));
+    contents += lines.back() + '\n';
+  }
+  writeFile(p, contents);
+  assert(readLines(p) == lines);
+  // no end of line after the last line; and a carriage return kept as part of its line
+  writeFile(p, contents + "put 1 2\r\nput 3 4");
+  lines.push_back("put 1 2\r");
+  lines.push_back("put 3 4");
+  assert(readLines(p) == lines);
+  writeFile(p, "");
+  assert(readLines(p).empty());
+  writeFile(p, "\n");
+  assert(readLines(p) == vector<string>(1, ""));
+  remove(p.c_str());
+  rmdir(dir);
+}
+
+// tokens are separated by any whitespace; the rest of the line is left after the token
+static void testNextToken() {
+  string_view s = "  put\t12 \v -3  ";
+  assert(nextToken(s) == "put" && s == "\t12 \v -3  ");
+  assert(nextToken(s) == "12");
+  assert(nextToken(s) == "-3");
+  assert(nextToken(s).empty() && s.empty());
+  assert(nextToken(s).empty());
+}
+
+// OUTPUT: true iff nextInt reads the single token s as the integer v
+static bool parsesAs(string_view s, int v) {
+  int w = v + 1;
+  return nextInt(s, w) && w == v;
+}
+
+// OUTPUT: true iff nextInt rejects the single token s
+static bool rejects(string_view s) {
+  int w;
+  return !nextInt(s, w);
+}
+
+// integers in the range of int, with an optional sign; anything else, out of range or not all digits, is rejected
+static void testNextInt() {
+  assert(parsesAs("0", 0) && parsesAs("-0", 0) && parsesAs("+0", 0));
+  assert(parsesAs("42", 42) && parsesAs("+42", 42) && parsesAs("-42", -42) && parsesAs("007", 7));
+  assert(parsesAs("2147483647", INT_MAX) && parsesAs("-2147483648", INT_MIN));
+  // out of the range of int (from_chars reports an overflow)
+  assert(rejects("2147483648") && rejects("-2147483649") && rejects("+2147483648"));
+  assert(rejects("99999999999999999999999999") && rejects("-99999999999999999999999999"));
+  // malformed
+  assert(rejects("") && rejects("+") && rejects("-") && rejects("+-1") && rejects("-+1") && rejects("++1"));
+  assert(rejects("12a") && rejects("a12") && rejects("1.5") && rejects("0x10") && rejects("1e3") && rejects("--1"));
+  // the token ends at whitespace, the rest of the line is left
+  string_view s = " 12 -7x 5";
+  int v = 0;
+  assert(nextInt(s, v) && v == 12);
+  assert(!nextInt(s, v) && s == " 5");
+  assert(nextInt(s, v) && v == 5 && !nextInt(s, v));
+}
+
+// every command by its name, and nothing else
+static void testParseCommand() {
+  pair<const char*, Command> commands[] = {
+    {"put", CMD_PUT}, {"erase", CMD_ERASE}, {"erase_range", CMD_ERASE_RANGE}, {"find", CMD_FIND},
+    {"size", CMD_SIZE}, {"select", CMD_SELECT}, {"rank", CMD_RANK}, {"median", CMD_MEDIAN},
+    {"range_stats", CMD_RANGE_STATS}, {"scan", CMD_SCAN}, {"node_visits", CMD_NODE_VISITS}, {"print", CMD_PRINT},
+    {"print_stats", CMD_PRINT_STATS}, {"print_tree", CMD_PRINT_TREE}, {"print_stats_tree", CMD_PRINT_STATS_TREE},
+    {"print_key_stats", CMD_PRINT_KEY_STATS}, {"noecho", CMD_NOECHO}, {"flush", CMD_FLUSH}, {"save", CMD_SAVE},
+    {"load", CMD_LOAD}, {"wal", CMD_WAL}, {"checkpoint", CMD_CHECKPOINT}, {"recover", CMD_RECOVER}
+  };
+  for (auto& c : commands) {
+    string name = c.first;
+    assert(parseCommand(name) == c.second);
+    // a prefix, an extension or a change of one letter of a name is not a command
+    assert(parseCommand(name.substr(0, name.size() - 1)) == CMD_UNKNOWN);
+    assert(parseCommand(name + "s") == CMD_UNKNOWN);
+    name[0] = (char) toupper(name[0]);
+    assert(parseCommand(name) == CMD_UNKNOWN);
+  }
+  assert(parseCommand("") == CMD_UNKNOWN && parseCommand("x") == CMD_UNKNOWN);
+}
+
+// commands with missing or malformed arguments are echoed, and otherwise ignored
+static void testDriverArguments() {
+  string commands =
+    "put 1 10\n"
+    "put 2\n"
+    "put\n"
+    "put x 3\n"
+    "put 3 30y\n"
+    "put 2147483648 1\n"
+    "put 4 -2147483649\n"
+    "put -2147483648 +2147483647\n"
+    "erase\n"
+    "erase one\n"
+    "erase_range 1\n"
+    "find\n"
+    "find 1.0\n"
+    "select\n"
+    "rank\n"
+    "scan 1\n"
+    "range_stats -5\n"
+    "print_key_stats\n"
+    "frobnicate 1 2\n"
+    "\n"
+    "   put   5\t50   \n"
+    "print\n"
+    "size\n";
+  string expected = commands;
+  expected.insert(expected.find("print\n") + 6, "[1:10]([-2147483648:2147483647](),()),([5:50](),())\n");
+  expected += "3\n";
+  assert(driverOutput(commands) == expected);
+}
+
+int main() {
+  testCommandReader();
+  testNextToken();
+  testNextInt();
+  testParseCommand();
+  testDriverArguments();
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
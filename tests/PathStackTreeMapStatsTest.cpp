@@ -0,0 +1,40 @@
+/*
+# Purpose: Tests of PathStackTreeMapStats: instantiated with int, unsigned and uint64_t values against a
+# std::map, and against BasicTreeMapStats, which it must build the same trees as
+*/
+
+#include <cstdint>
+
+#include "../BasicTreeMapStats.h"
+#include "../PathStackTreeMapStats.h"
+#include "MapModelCheck.h"
+
+// long runs of increasing and decreasing keys, which rotate along the whole path of the stack on the way up
+static void testSequential() {
+  PathStackTreeMapStats<int, int> up, down;
+  BasicTreeMapStats<int, int> basicUp, basicDown;
+  for (int i = 0; i < 100000; i++) {
+    up.put(i, i);
+    basicUp.put(i, i);
+    down.put(-i, i);
+    basicDown.put(-i, i);
+  }
+  assert(shape(up) == shape(basicUp) && shape(down) == shape(basicDown));
+  for (int i = 0; i < 100000; i += 2) {
+    up.erase(i);
+    down.erase(-i);
+  }
+  assert(up.size() == 50000 && down.size() == 50000 && up.stats().sum == down.stats().sum);
+  // a node has no parent link
+  assert(sizeof(PathStackTreeMapStats<int, int>::Node) < sizeof(BasicTreeMapStats<int, int>::Node));
+}
+
+int main() {
+  std::mt19937_64 rng(25);
+  checkAgainstBasic<PathStackTreeMapStats<int, int>, BasicTreeMapStats<int, int>, int>(rng);
+  checkAgainstBasic<PathStackTreeMapStats<int, unsigned>, BasicTreeMapStats<int, unsigned>, unsigned>(rng);
+  checkAgainstBasic<PathStackTreeMapStats<int, uint64_t>, BasicTreeMapStats<int, uint64_t>, uint64_t>(rng);
+  testSequential();
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+/*
+# Purpose: Tests of PersistentTreeMapStats: instantiated with int, unsigned and uint64_t values against a
+# std::map, and snapshots that keep their entries while the map (or another snapshot) is updated
+*/
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "../PersistentTreeMapStats.h"
+#include "MapModelCheck.h"
+
+// OUTPUT: true iff key k is in map m, in which case its value is stored in *v
+template <class Map, class V>
+bool findValue(const Map& m, int k, V* v) {
+  const typename Map::Node* w = m.find(k);
+  if (w) *v = w->value;
+  return w != NULL;
+}
+
+/*
+  # INPUT: a random generator
+  # POSTCONDITION: random updates are checked against a std::map, with values of type V; a snapshot is taken at
+  # every check, and every snapshot must still hold the entries it had when taken once the updates are done
+*/
+template <class V>
+void testModel(std::mt19937_64& rng) {
+  typedef PersistentTreeMapStats<int, V> Map;
+  Map m;
+  std::map<int,V> model;
+  std::vector<std::pair<Map, std::map<int,V> > > snapshots;
+  checkRandomUpdates(m, model, findValue<Map, V>, 20000, 2000, rng, 1000,
+                     [&rng, &snapshots](const Map& m, const std::map<int,V>& model) {
+                       checkRandomRanges(m, model, [](const Map& m, int lo, int hi) { return m.rangeStats(lo, hi); },
+                                         2000, rng);
+                       snapshots.push_back(std::make_pair(m.snapshot(), model));
+                     });
+  for (size_t i = 0; i < snapshots.size(); i++) {
+    const Map& s = snapshots[i].first;
+    const std::map<int,V>& e = snapshots[i].second;
+    assert(s.size() == e.size());
+    for (auto& x : e) {
+      V v = V();
+      assert(findValue(s, x.first, &v) && v == x.second);
+    }
+    checkRandomRanges(s, e, [](const Map& m, int lo, int hi) { return m.rangeStats(lo, hi); }, 2000, rng);
+  }
+  m.clear();
+  assert(m.empty() && m.stats().num == 0 && snapshots.back().first.size() == snapshots.back().second.size());
+}
+
+// copies, moves and assignments share the tree (O(1)), and are independent once updated
+static void testCopies() {
+  typedef PersistentTreeMapStats<int, int> Map;
+  Map a;
+  for (int i = 0; i < 100; i++) a.put(i, i);
+  Map b(a), c;
+  c = a;
+  b.put(1000, 1);
+  c.erase(5);
+  assert(a.size() == 100 && b.size() == 101 && c.size() == 99);
+  assert(!a.find(1000) && a.find(5) && b.find(5) && !c.find(5));
+  Map d(std::move(b));
+  assert(d.size() == 101 && b.empty());
+  c = std::move(d);
+  assert(c.size() == 101 && c.find(1000));
+  a = a;
+  assert(a.size() == 100 && a.stats().sum == 4950);
+}
+
+int main() {
+  std::mt19937_64 rng(20);
+  testModel<int>(rng);
+  testModel<unsigned>(rng);
+  testModel<uint64_t>(rng);
+  testCopies();
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+/*
+# Purpose: Tests of TreeMapStats::rangeStats against std::map: the stats of the entries with keys in [lo, hi],
+# for random windows (including reversed ones) of maps under random updates, and for every window of small maps
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "MapModelCheck.h"
+#include "TreeMapStatsCheck.h"
+
+// the stats of a range of TreeMapStats, with the fields that checkStats compares (the sum does not wrap around)
+struct RangeAggregate {
+  size_t num;
+  long long sum;
+  long long wraps;
+  int min;
+  int max;
+};
+
+// OUTPUT: the stats of the entries of m with keys in [lo, hi]
+static RangeAggregate range(const TreeMapStats& m, int lo, int hi) {
+  TreeMapStats::Node::Stats s = m.rangeStats(lo, hi);
+  return RangeAggregate{(size_t) s.getNum(), s.getSum(), 0, s.getMin(), s.getMax()};
+}
+
+// random updates (values over the whole range of int), with random windows checked along the way
+static void testRandom(mt19937_64& rng) {
+  for (int keys : {10, 1000, 100000}) {
+    CheckedTreeMapStats m;
+    map<int,int> model;
+    checkRandomUpdates(m, model, [](const TreeMapStats& t, int k, int* v) {
+      const BSTMap::Node* w = t.find(k);
+      if (w) *v = w->value;
+      return w != NULL;
+    }, 4 * keys, keys, rng, max(1, keys / 20), [&rng, keys](const CheckedTreeMapStats& t, const map<int,int>& e) {
+      assert(t.valid());
+      checkRandomRanges(t, e, range, keys, rng);
+    });
+  }
+}
+
+// every window, with bounds on, between and beyond the keys, of small maps with extreme values
+static void testAllWindows(mt19937_64& rng) {
+  for (int n : {0, 1, 2, 3, 7, 40}) {
+    map<int,int> e;
+    for (int i = 0; i < n; i++) e[3 * i] = (i % 3 == 0) ? INT_MAX : (i % 3 == 1) ? INT_MIN : (int) rng();
+    CheckedTreeMapStats m;
+    for (auto& x : e) m.put(x.first, x.second);
+    for (int lo = -2; lo <= 3 * n + 1; lo++)
+      for (int hi = -2; hi <= 3 * n + 1; hi++)
+        checkStats(e, lo, hi, range(m, lo, hi));
+    checkStats(e, INT_MIN, INT_MAX, range(m, INT_MIN, INT_MAX));
+    checkStats(e, INT_MAX, INT_MIN, range(m, INT_MAX, INT_MIN));
+  }
+}
+
+int main() {
+  mt19937_64 rng(7);
+  testRandom(rng);
+  testAllWindows(rng);
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+/*
+# Purpose: Tests of the range scans (BSTMap::scan and BSTMap::printRange) and of the scan command of the driver:
+# the entries visited and printed are those of a std::map in the window [lo, hi], in order, up to the limit
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "DriverCheck.h"
+#include "TreeMapStatsCheck.h"
+
+// OUTPUT: the first (at most limit, if not negative) entries of model e with keys in [lo, hi]
+static vector<pair<int,int> > window(const map<int,int>& e, int lo, int hi, int limit) {
+  vector<pair<int,int> > w;
+  if (lo > hi) return w;
+  for (map<int,int>::const_iterator i = e.lower_bound(lo); i != e.end() && i->first <= hi; ++i) {
+    if ((int) w.size() == limit) break;
+    w.push_back(*i);
+  }
+  return w;
+}
+
+// OUTPUT: the line printed for entries w by printRange
+static string line(const vector<pair<int,int> >& w) {
+  string s;
+  for (size_t i = 0; i < w.size(); i++)
+    s += (i ? " " : "") + to_string(w[i].first) + ":" + to_string(w[i].second);
+  return s + "\n";
+}
+
+// POSTCONDITION: scan and printRange of map m (printing to the file at path p) agree with model e on a window
+static void checkWindow(TreeMapStats& m, const map<int,int>& e, const string& p, int lo, int hi, int limit) {
+  vector<pair<int,int> > expected = window(e, lo, hi, limit);
+  vector<pair<int,int> > visited;
+  int count = m.scan(lo, hi, limit, [&visited](const BSTMap::Node* w) { visited.push_back(make_pair(w->key, w->value)); });
+  assert(visited == expected && count == (int) expected.size());
+  FILE* f = fopen(p.c_str(), "wb");
+  assert(f);
+  {
+    OutputSink out(f);
+    m.setOutput(out);
+    assert(m.printRange(lo, hi, limit) == (int) expected.size());
+    m.setOutput(defaultOutput());
+  }
+  fclose(f);
+  assert(readFile(p) == line(expected));
+}
+
+// windows with bounds in the map or not, inside, around and past its keys, empty or reversed, with and without limits
+static void testWindows(mt19937_64& rng, const string& p) {
+  for (int n : {0, 1, 2, 50, 3000}) {
+    map<int,int> e = randomEntries(n, 4 * n + 1, rng);
+    CheckedTreeMapStats m(e);
+    vector<int> bounds = { INT_MIN, INT_MIN + 1, -1, 0, 1, 2 * n, 4 * n, 4 * n + 1, INT_MAX - 1, INT_MAX };
+    for (auto& x : e) {
+      if (rng() % (n / 8 + 1) == 0) {
+        bounds.push_back(x.first);
+        bounds.push_back(x.first - 1);
+        bounds.push_back(x.first + 1);
+      }
+    }
+    for (int lo : bounds) {
+      for (int hi : bounds) {
+        int all = (int) window(e, lo, hi, -1).size();
+        for (int limit : {-1, -100, 0, 1, all - 1, all, all + 1}) {
+          if (limit < -1 && n > 50) continue;
+          checkWindow(m, e, p, lo, hi, limit);
+        }
+      }
+    }
+  }
+}
+
+// the scan command, with and without a limit; a malformed limit is no limit, and a missing bound skips the scan
+static void testCommand() {
+  string commands =
+    "noecho\n"
+    "scan 0 100\n"
+    "put 5 50\n"
+    "put 1 10\n"
+    "put 9 90\n"
+    "put 7 70\n"
+    "put 3 30\n"
+    "scan 0 100\n"
+    "scan 3 7\n"
+    "scan 4 6\n"
+    "scan 6 6\n"
+    "scan 7 3\n"
+    "scan -2147483648 2147483647 2\n"
+    "scan 2 9 0\n"
+    "scan 2 9 -1\n"
+    "scan 2 9 10\n"
+    "scan 2 9 x\n"
+    "scan 2\n"
+    "scan\n"
+    "erase 5\n"
+    "scan 4 6\n"
+    "scan 1 9 3\n";
+  string expected =
+    "noecho\n"
+    "\n"
+    "1:10 3:30 5:50 7:70 9:90\n"
+    "3:30 5:50 7:70\n"
+    "5:50\n"
+    "\n"
+    "\n"
+    "1:10 3:30\n"
+    "\n"
+    "3:30 5:50 7:70 9:90\n"
+    "3:30 5:50 7:70 9:90\n"
+    "3:30 5:50 7:70 9:90\n"
+    "\n"
+    "1:10 3:30 7:70\n";
+  assert(driverOutput(commands) == expected);
+}
+
+int main() {
+  char dir[] = "/tmp/scan-XXXXXX";
+  assert(mkdtemp(dir));
+  string p = string(dir) + "/output.txt";
+  mt19937_64 rng(14);
+  testWindows(rng, p);
+  testCommand();
+  remove(p.c_str());
+  rmdir(dir);
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
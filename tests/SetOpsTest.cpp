@@ -0,0 +1,83 @@
+/*
+# Purpose: Tests of the set operations of TreeMapStats (unionWith, intersectWith, difference), sequential and
+# split among threads, against the same operations on std::map
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "TreeMapStatsCheck.h"
+
+// OUTPUT: the expected result of each set operation of a with b (see TreeMapStats::unionWith)
+static map<int,int> unionOf(const map<int,int>& a, const map<int,int>& b) {
+  map<int,int> r(b);
+  r.insert(a.begin(), a.end());
+  return r;
+}
+static map<int,int> intersectionOf(const map<int,int>& a, const map<int,int>& b) {
+  map<int,int> r;
+  for (auto& x : a)
+    if (b.count(x.first)) r.insert(x);
+  return r;
+}
+static map<int,int> differenceOf(const map<int,int>& a, const map<int,int>& b) {
+  map<int,int> r;
+  for (auto& x : a)
+    if (!b.count(x.first)) r.insert(x);
+  return r;
+}
+
+/*
+  # INPUT: two sets of entries a and b; a number of threads
+  # POSTCONDITION: each set operation of maps of a and b gives the expected entries, in a proper tree, and
+  # empties the other map
+*/
+static void checkSetOps(const map<int,int>& a, const map<int,int>& b, int threads) {
+  {
+    CheckedTreeMapStats m(a), other(b);
+    m.unionWith(other, threads);
+    assert(m.valid() && other.valid() && other.empty());
+    assert(entries(m) == unionOf(a, b));
+  }
+  {
+    CheckedTreeMapStats m(a), other(b);
+    m.intersectWith(other, threads);
+    assert(m.valid() && other.valid() && other.empty());
+    assert(entries(m) == intersectionOf(a, b));
+  }
+  {
+    CheckedTreeMapStats m(a), other(b);
+    m.difference(other, threads);
+    assert(m.valid() && other.valid() && other.empty());
+    assert(entries(m) == differenceOf(a, b));
+    // the map stays usable after the nodes of other were moved into it
+    m.put(-1, 1);
+    m.erase(m.empty() ? 0 : m.begin()->key);
+    assert(m.valid());
+  }
+}
+
+int main() {
+  mt19937_64 rng(16);
+  // small maps, of equal and very different sizes, overlapping or not
+  for (int n : {0, 1, 10, 300}) {
+    for (int m : {0, 1, 7, 1000}) {
+      map<int,int> a = randomEntries(n, 2 * (n + m) + 1, rng);
+      map<int,int> b = randomEntries(m, 2 * (n + m) + 1, rng);
+      checkSetOps(a, b, 1);
+      checkSetOps(b, a, 1);
+    }
+  }
+  // maps large enough to be split among threads (see TreeMapStats::PARALLEL_GRAIN)
+  map<int,int> a = randomEntries(200000, 400000, rng);
+  map<int,int> b = randomEntries(150000, 400000, rng);
+  for (int threads : {1, 2, 4, 0}) checkSetOps(a, b, threads);
+  // a map with itself
+  CheckedTreeMapStats m(a);
+  m.unionWith(m);
+  m.intersectWith(m);
+  assert(entries(m) == a);
+  m.difference(m);
+  assert(m.empty() && m.valid());
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+/*
+# Purpose: Tests of the binary snapshots of the maps (BSTMap::saveSnapshot and BSTMap::loadSnapshot): a saved
+# map is loaded back as a proper tree with the same entries, and damaged files are rejected without changing
+# the map
+*/
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+#include "TreeMapStatsCheck.h"
+#include <unistd.h>
+
+// path of the snapshot file of the tests
+static string path;
+
+// OUTPUT: the contents of the file at path p
+static string readFile(const string& p) {
+  string s;
+  FILE* f = fopen(p.c_str(), "rb");
+  assert(f);
+  char buf[4096];
+  size_t r;
+  while ((r = fread(buf, 1, sizeof(buf), f)) > 0) s.append(buf, r);
+  fclose(f);
+  return s;
+}
+
+// POSTCONDITION: the file at path p holds exactly s
+static void writeFile(const string& p, const string& s) {
+  FILE* f = fopen(p.c_str(), "wb");
+  assert(f && fwrite(s.data(), 1, s.size(), f) == s.size());
+  fclose(f);
+}
+
+// maps of several sizes are saved and loaded back, into empty and non-empty maps of each class
+static void testRoundTrip(mt19937_64& rng) {
+  for (int n : {0, 1, 2, 3, 100, 65536, 100000}) {
+    map<int,int> e = randomEntries(n, INT_MAX, rng);
+    CheckedTreeMapStats m(e);
+    assert(m.saveSnapshot(path));
+    assert(readFile(path).size() == SNAPSHOT_HEADER_BYTES + e.size() * SNAPSHOT_ENTRY_BYTES + SNAPSHOT_TRAILER_BYTES);
+    CheckedTreeMapStats loaded(randomEntries(10, 100, rng));
+    assert(loaded.loadSnapshot(path));
+    assert(loaded.valid() && entries(loaded) == e && loaded.size() == (int) e.size());
+    loaded.put(-1, -1);
+    loaded.erase(e.empty() ? 0 : e.begin()->first);
+    assert(loaded.valid());
+    // the format does not depend on the class of the map
+    BSTMap plain;
+    assert(plain.loadSnapshot(path) && entries(plain) == e);
+    AVLTreeMap avl;
+    assert(avl.loadSnapshot(path) && entries(avl) == e);
+  }
+}
+
+/*
+  # POSTCONDITION: every damaged copy of a valid snapshot is rejected: cut short, extended, with any single
+  # byte changed, or with keys out of order (with a matching checksum); the map it is loaded into is unchanged
+*/
+static void testDamaged(mt19937_64& rng) {
+  map<int,int> e = randomEntries(50, 1000, rng);
+  CheckedTreeMapStats m(e);
+  assert(m.saveSnapshot(path));
+  string good = readFile(path);
+  map<int,int> before = randomEntries(20, 100, rng);
+  CheckedTreeMapStats target(before);
+  vector<string> damaged;
+  damaged.push_back(good.substr(0, good.size() - 1));
+  damaged.push_back(good.substr(0, SNAPSHOT_HEADER_BYTES));
+  damaged.push_back(good + '\0');
+  damaged.push_back(string());
+  for (size_t i = 0; i < good.size(); i++) {
+    string s = good;
+    s[i] ^= 0x20;
+    damaged.push_back(s);
+  }
+  // keys out of order, with a valid checksum
+  vector<pair<int,int> > swapped(e.begin(), e.end());
+  swap(swapped[3], swapped[4]);
+  string s = good.substr(0, SNAPSHOT_HEADER_BYTES);
+  SnapshotChecksum sum;
+  char buf[SNAPSHOT_ENTRY_BYTES + SNAPSHOT_TRAILER_BYTES];
+  for (size_t i = 0; i < swapped.size(); i++) {
+    putLE(buf, (uint32_t) swapped[i].first, 4);
+    putLE(buf + 4, (uint32_t) swapped[i].second, 4);
+    s.append(buf, SNAPSHOT_ENTRY_BYTES);
+    sum.add(swapped[i].first, swapped[i].second);
+  }
+  putLE(buf, sum.value(), 8);
+  s.append(buf, SNAPSHOT_TRAILER_BYTES);
+  damaged.push_back(s);
+  for (size_t i = 0; i < damaged.size(); i++) {
+    writeFile(path, damaged[i]);
+    assert(!target.loadSnapshot(path));
+    assert(target.valid() && entries(target) == before);
+  }
+  remove(path.c_str());
+  assert(!target.loadSnapshot(path));
+  assert(!m.saveSnapshot("/nonexistent-directory/snapshot"));
+}
+
+int main() {
+  char tmpl[] = "/tmp/snapshot-test-XXXXXX";
+  assert(mkdtemp(tmpl));
+  path = string(tmpl) + "/snap";
+  mt19937_64 rng(21);
+  testRoundTrip(rng);
+  testDamaged(rng);
+  remove(path.c_str());
+  rmdir(tmpl);
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}
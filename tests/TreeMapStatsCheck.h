@@ -0,0 +1,64 @@
+/*
+# Purpose: Shared checks of the tests of the maps of Main.cpp (which must be included first): a TreeMapStats
+# whose whole structure (order, parent links, heights, balance and stats of every node) can be checked, and the
+# entries of any map as a std::map
+*/
+
+#ifndef TREE_MAP_STATS_CHECK_H
+#define TREE_MAP_STATS_CHECK_H
+
+#include <cassert>
+#include <climits>
+#include <map>
+#include <random>
+
+// OUTPUT: the entries of map m, in a std::map
+inline map<int,int> entries(const BSTMap& m) {
+  map<int,int> e;
+  for (BSTMap::iterator i = m.begin(); i != m.end(); ++i)
+    e[i->key] = i->value;
+  return e;
+}
+
+// OUTPUT: n random entries with keys in [0, keys) (fewer if keys repeat), in a std::map
+inline map<int,int> randomEntries(int n, int keys, mt19937_64& rng) {
+  uniform_int_distribution<int> key(0, keys - 1);
+  uniform_int_distribution<int> value(INT_MIN, INT_MAX);
+  map<int,int> e;
+  for (int i = 0; i < n; i++) e[key(rng)] = value(rng);
+  return e;
+}
+
+// TreeMapStats with a check of its structure
+class CheckedTreeMapStats : public TreeMapStats {
+
+public:
+  CheckedTreeMapStats() { };
+  explicit CheckedTreeMapStats(const map<int,int>& e) : TreeMapStats(vector<pair<int,int> >(e.begin(), e.end()), true) { };
+
+  // OUTPUT: true iff the tree is a proper AVL tree with consistent parent links, heights and stats, whose
+  // number of entries is size()
+  bool valid() const {
+    int ht;
+    return validAux((const Node*) root, NULL, (long long) INT_MIN - 1, (long long) INT_MAX + 1, ht) && num(root) == size();
+  };
+
+private:
+  // OUTPUT: true iff the subtree rooted at w, a child of parent, is valid with keys in (lo, hi); its height is stored in ht
+  static bool validAux(const Node* w, const Node* parent, long long lo, long long hi, int& ht) {
+    ht = 0;
+    if (!w) return true;
+    int l, r;
+    if (w->parent != parent || w->key <= lo || w->key >= hi) return false;
+    if (!validAux((const Node*) w->left, w, lo, w->key, l) || !validAux((const Node*) w->right, w, w->key, hi, r))
+      return false;
+    ht = 1 + max(l, r);
+    if (w->ht != ht || l - r > 1 || r - l > 1) return false;
+    Node::Stats s(w->value, (Node*) w->left, (Node*) w->right);
+    const Node::Stats& t = w->getInfo();
+    return s.getNum() == t.getNum() && s.getSum() == t.getSum() && s.getMin() == t.getMin() && s.getMax() == t.getMax();
+  };
+  static int num(const BSTMap::Node* w) { return w ? ((const Node*) w)->getNum() : 0; };
+};
+
+#endif // TREE_MAP_STATS_CHECK_H
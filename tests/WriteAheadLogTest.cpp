@@ -0,0 +1,209 @@
+/*
+# Purpose: Tests of WriteAheadLog: a map with a log attached is recovered, from copies of its snapshot and log
+# files taken at some point (as a crash would leave them), to the entries it had at that point; the bulk
+# updates that are not recorded to the log (snapshot loads, bulk loads, clear, split, join, set operations)
+# must checkpoint it
+*/
+
+#include <cassert>
+#include <map>
+
+#define TREE_MAP_STATS_NO_MAIN
+#include "../Main.cpp"
+
+// directory of the files of the tests, and the paths of the log and snapshot files in it
+static string dir;
+static string logPath() { return dir + "/log"; }
+static string snapPath() { return dir + "/snap"; }
+
+// OUTPUT: the entries of map m, in a std::map
+static map<int,int> entries(const BSTMap& m) {
+  map<int,int> e;
+  for (BSTMap::iterator i = m.begin(); i != m.end(); ++i)
+    e[i->key] = i->value;
+  return e;
+}
+
+// POSTCONDITION: the file at path to (if any) is a copy of the file at path from (removed if there is none)
+static void copyFile(const string& from, const string& to) {
+  remove(to.c_str());
+  FILE* f = fopen(from.c_str(), "rb");
+  if (!f) return;
+  FILE* g = fopen(to.c_str(), "wb");
+  assert(g);
+  char buf[4096];
+  size_t r;
+  while ((r = fread(buf, 1, sizeof(buf), f)) > 0)
+    assert(fwrite(buf, 1, r, g) == r);
+  fclose(f);
+  fclose(g);
+}
+
+// OUTPUT: the entries of a map recovered from copies of the current snapshot and log files (as if the
+// process had crashed now: the map and the log that are still open are left alone)
+static map<int,int> recoverAfterCrash() {
+  copyFile(snapPath(), dir + "/crash.snap");
+  copyFile(logPath(), dir + "/crash.log");
+  TreeMapStats r;
+  assert(WriteAheadLog::recover(r, dir + "/crash.snap", dir + "/crash.log"));
+  return entries(r);
+}
+
+// OUTPUT: the size in bytes of the file at path (-1 if there is none)
+static long fileSize(const string& path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 ? (long) st.st_size : -1;
+}
+
+// POSTCONDITION: the log and snapshot files are removed
+static void reset() {
+  remove(logPath().c_str());
+  remove(snapPath().c_str());
+}
+
+// put, erase and eraseRange are replayed from the log
+static void testReplay() {
+  reset();
+  WriteAheadLog wal;
+  TreeMapStats m;
+  assert(wal.open(logPath(), snapPath()));
+  m.setLog(&wal);
+  for (int i = 0; i < 100; i++) m.put(i, i * i);
+  m.erase(3);
+  m.eraseRange(10, 40);
+  m.put(50, -1);
+  assert(wal.good());
+  assert(recoverAfterCrash() == entries(m));
+  // a checkpoint empties the log, and later updates follow on from the snapshot
+  assert(wal.checkpoint(m));
+  assert(fileSize(logPath()) == 0);
+  m.erase(60);
+  assert(recoverAfterCrash() == entries(m));
+  m.setLog(NULL);
+}
+
+// a snapshot loaded into a map with a log attached, then updated, is recovered with the update
+static void testLoadSnapshot() {
+  reset();
+  string other = dir + "/other";
+  TreeMapStats x;
+  x.put(5, 50);
+  x.put(7, 70);
+  assert(x.saveSnapshot(other));
+  WriteAheadLog wal;
+  TreeMapStats m;
+  assert(wal.open(logPath(), snapPath()));
+  m.setLog(&wal);
+  m.put(1, 10);
+  assert(m.loadSnapshot(other));
+  m.put(2, 2);
+  map<int,int> expected = { {2, 2}, {5, 50}, {7, 70} };
+  assert(entries(m) == expected);
+  assert(recoverAfterCrash() == expected);
+  m.setLog(NULL);
+  remove(other.c_str());
+}
+
+// bulkLoad and clear are not recorded one entry at a time, but they are recovered
+static void testBulkLoadAndClear() {
+  reset();
+  WriteAheadLog wal;
+  TreeMapStats m;
+  assert(wal.open(logPath(), snapPath()));
+  m.setLog(&wal);
+  m.put(-1, -1);
+  vector<pair<int,int> > e;
+  for (int i = 0; i < 50; i++) e.push_back(make_pair(i * 2, i));
+  m.bulkLoad(e, true);
+  m.put(7, 7);
+  assert(recoverAfterCrash() == entries(m));
+  m.clear();
+  m.put(9, 9);
+  map<int,int> expected = { {9, 9} };
+  assert(recoverAfterCrash() == expected);
+  m.setLog(NULL);
+}
+
+// entries moved out of or into a map with a log attached, by split, join and the set operations, are recovered
+static void testMoves() {
+  reset();
+  WriteAheadLog wal;
+  TreeMapStats m, right;
+  assert(wal.open(logPath(), snapPath()));
+  m.setLog(&wal);
+  for (int i = 0; i < 100; i++) m.put(i, i);
+  assert(m.split(50, right));
+  m.put(200, 200);
+  assert(recoverAfterCrash() == entries(m));
+  assert(m.join(right) == false);
+  m.erase(200);
+  assert(m.join(right));
+  assert(entries(m).size() == 100);
+  assert(recoverAfterCrash() == entries(m));
+
+  TreeMapStats other;
+  for (int i = 90; i < 150; i++) other.put(i, -i);
+  m.unionWith(other, 1);
+  assert(recoverAfterCrash() == entries(m));
+  for (int i = 0; i < 120; i += 3) other.put(i, 0);
+  m.intersectWith(other, 1);
+  assert(recoverAfterCrash() == entries(m));
+  for (int i = 0; i < 120; i += 9) other.put(i, 0);
+  m.difference(other, 1);
+  m.put(1000, 1);
+  assert(recoverAfterCrash() == entries(m));
+  m.setLog(NULL);
+}
+
+// each record is written to the log file when it is appended, even if its sync is deferred to a later commit
+static void testGroupCommit() {
+  reset();
+  WriteAheadLog wal(1000, 0);
+  TreeMapStats m;
+  assert(wal.open(logPath(), snapPath()));
+  m.setLog(&wal);
+  for (int i = 0; i < 10; i++) m.put(i, i);
+  assert(fileSize(logPath()) == 10 * 16);
+  assert(recoverAfterCrash() == entries(m));
+  assert(wal.commit());
+  m.setLog(NULL);
+}
+
+// recovery stops at a torn record at the end of the log, and cuts it off
+static void testTornRecord() {
+  reset();
+  WriteAheadLog wal;
+  TreeMapStats m;
+  assert(wal.open(logPath(), snapPath()));
+  m.setLog(&wal);
+  m.put(1, 1);
+  m.put(2, 2);
+  m.setLog(NULL);
+  assert(wal.close());
+  FILE* f = fopen(logPath().c_str(), "ab");
+  assert(f);
+  fwrite("\x01\x00\x00\x00\x03\x00", 1, 6, f);
+  fclose(f);
+  TreeMapStats r;
+  assert(WriteAheadLog::recover(r, snapPath(), logPath()));
+  assert(entries(r) == entries(m));
+  assert(fileSize(logPath()) == 2 * 16);
+}
+
+int main() {
+  char tmpl[] = "/tmp/wal-test-XXXXXX";
+  assert(mkdtemp(tmpl));
+  dir = tmpl;
+  testReplay();
+  testLoadSnapshot();
+  testBulkLoadAndClear();
+  testMoves();
+  testGroupCommit();
+  testTornRecord();
+  reset();
+  remove((dir + "/crash.snap").c_str());
+  remove((dir + "/crash.log").c_str());
+  rmdir(dir.c_str());
+  printf("OK\n");
+  return EXIT_SUCCESS;
+}